@@ -0,0 +1,647 @@
+/**
+ * bszenlib-bench
+ * ==============
+ *
+ * Runs the single importer steps on synthetic data and reports how fast they are. No game
+ * files are needed, so this can run anywhere bs::f can be started with its null backends.
+ *
+ * Usage:
+ *
+ *     bszenlib-bench [--iterations=N] [--only=tex,mesh,skel,man] [--texture-size=N]
+ *                    [--vertices=N] [--frames=N] [--mip-filter=kaiser|box]
+ *
+ * All inputs are generated from a fixed seed, so two runs with the same options work on the
+ * same data. Each benchmark runs once to warm up before it is measured.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "BsApplication.h"
+#include <BsZenLib/ImportAnimation.hpp>
+#include <BsZenLib/ImportSkeletalMesh.hpp>
+#include <BsZenLib/ImportStaticMesh.hpp>
+#include <BsZenLib/ImportTexture.hpp>
+#include <BsZenLib/MeshOptimization.hpp>
+#include <zenload/zTypes.h>
+
+using namespace bs;
+
+using BenchClock = std::chrono::steady_clock;
+
+/**
+ * Every benchmark generates its data from this seed, so the inputs don't change with the
+ * selection of benchmarks to run.
+ */
+constexpr UINT32 BENCH_SEED = 1337;
+
+/**
+ * Formats of the zTEX header, as written by the game.
+ */
+enum class ZTEXFormat : UINT32
+{
+  A8R8G8B8 = 3,
+  R5G6B5 = 8,
+  P8 = 9,
+  DXT1 = 10,
+  DXT5 = 14,
+};
+
+struct BenchOptions
+{
+  UINT32 iterations = 10;
+  UINT32 textureSize = 1024;
+  UINT32 vertices = 64 * 1024;
+  UINT32 frames = 256;
+  BsZenLib::TextureMipFilter mipFilter = BsZenLib::TextureMipFilter::Kaiser;
+
+  bool textures = true;
+  bool staticMeshes = true;
+  bool skeletalMeshes = true;
+  bool animations = true;
+};
+
+struct BenchResult
+{
+  String name;
+  UINT32 iterations = 0;
+  double secondsPerIteration = 0.0;
+  UINT64 bytesIn = 0;
+  UINT64 items = 0;
+  const char* itemName = "";
+  bool failed = false;
+};
+
+static void printUsage()
+{
+  std::cout << "Usage: bszenlib-bench [options]" << std::endl
+            << std::endl
+            << "Options:" << std::endl
+            << "  --iterations=N     Measure each benchmark N times (Default: 10)" << std::endl
+            << "  --only=KINDS       Only run the given benchmarks, separated by comma."
+            << std::endl
+            << "                     Kinds are: tex, mesh, skel, man (Default: all of them)"
+            << std::endl
+            << "  --texture-size=N   Width and height of the textures (Default: 1024)"
+            << std::endl
+            << "  --vertices=N       Number of vertices of the meshes (Default: 65536)"
+            << std::endl
+            << "  --frames=N         Number of frames of the animation (Default: 256)"
+            << std::endl
+            << "  --mip-filter=F     Filter for mip-maps of uncompressed textures: kaiser, box"
+            << std::endl
+            << "                     (Default: kaiser)" << std::endl;
+}
+
+/**
+ * Runs the given function once to warm up, then the given number of times while measuring.
+ *
+ * @param run  Runs the benchmark once, returns false if it failed.
+ */
+static BenchResult runBenchmark(const String& name, UINT32 iterations,
+                                const std::function<bool()>& run)
+{
+  BenchResult result;
+  result.name = name;
+  result.iterations = iterations;
+
+  if (!run())
+  {
+    result.failed = true;
+    return result;
+  }
+
+  BenchClock::time_point start = BenchClock::now();
+
+  for (UINT32 i = 0; i < iterations; i++)
+  {
+    run();
+  }
+
+  std::chrono::duration<double> elapsed = BenchClock::now() - start;
+  result.secondsPerIteration = elapsed.count() / iterations;
+
+  return result;
+}
+
+static void printResult(const BenchResult& result)
+{
+  std::cout << std::left << std::setw(36) << result.name << std::right;
+
+  if (result.failed)
+  {
+    std::cout << "  FAILED" << std::endl;
+    return;
+  }
+
+  double megabytesPerSecond = (result.bytesIn / (1024.0 * 1024.0)) / result.secondsPerIteration;
+  double itemsPerSecond = result.items / result.secondsPerIteration;
+
+  std::cout << std::fixed << std::setprecision(3) << std::setw(12)
+            << result.secondsPerIteration * 1000.0 << " ms" << std::setw(12)
+            << std::setprecision(1) << megabytesPerSecond << " MB/s" << std::setw(14)
+            << std::setprecision(0) << itemsPerSecond << " " << result.itemName << "/s"
+            << std::endl;
+}
+
+// - Synthetic Data --------------------------------------------------------------------------------
+
+static void writeUINT32(std::vector<uint8_t>& out, UINT32 value)
+{
+  out.push_back((uint8_t)(value >> 0));
+  out.push_back((uint8_t)(value >> 8));
+  out.push_back((uint8_t)(value >> 16));
+  out.push_back((uint8_t)(value >> 24));
+}
+
+static UINT32 mipSizeInBytes(ZTEXFormat format, UINT32 width, UINT32 height)
+{
+  switch (format)
+  {
+    case ZTEXFormat::DXT1:
+      return std::max(1u, width / 4) * std::max(1u, height / 4) * 8;
+    case ZTEXFormat::DXT5:
+      return std::max(1u, width / 4) * std::max(1u, height / 4) * 16;
+    case ZTEXFormat::R5G6B5:
+      return width * height * 2;
+    case ZTEXFormat::P8:
+      return width * height;
+    case ZTEXFormat::A8R8G8B8:
+    default:
+      return width * height * 4;
+  }
+}
+
+/**
+ * Builds a compiled .TEX-file with a full mip chain filled with noise.
+ */
+static std::vector<uint8_t> makeZTEX(ZTEXFormat format, UINT32 size, std::mt19937& random)
+{
+  UINT32 numMips = 1;
+  while ((size >> numMips) > 0)
+  {
+    numMips++;
+  }
+
+  std::vector<uint8_t> ztex;
+
+  writeUINT32(ztex, 0x5845545A);      // "ZTEX"
+  writeUINT32(ztex, 0);               // Version
+  writeUINT32(ztex, (UINT32)format);  // Format
+  writeUINT32(ztex, size);            // Width
+  writeUINT32(ztex, size);            // Height
+  writeUINT32(ztex, numMips);         // Number of mip-maps
+  writeUINT32(ztex, size);            // Reference width
+  writeUINT32(ztex, size);            // Reference height
+  writeUINT32(ztex, 0xFF808080);      // Average color
+
+  if (format == ZTEXFormat::P8)
+  {
+    // Palette of 256 colors
+    for (UINT32 i = 0; i < 256 * 4; i++)
+    {
+      ztex.push_back((uint8_t)random());
+    }
+  }
+
+  // zTEX stores the smallest mip-map first
+  for (UINT32 mip = numMips; mip-- > 0;)
+  {
+    UINT32 mipSize = std::max(1u, size >> mip);
+    UINT32 numBytes = mipSizeInBytes(format, mipSize, mipSize);
+
+    for (UINT32 i = 0; i < numBytes; i++)
+    {
+      ztex.push_back((uint8_t)random());
+    }
+  }
+
+  return ztex;
+}
+
+static ZMath::float3 randomFloat3(std::mt19937& random, float range)
+{
+  std::uniform_real_distribution<float> distribution(-range, range);
+
+  ZMath::float3 v;
+  v.x = distribution(random);
+  v.y = distribution(random);
+  v.z = distribution(random);
+
+  return v;
+}
+
+static ZMath::float2 randomFloat2(std::mt19937& random)
+{
+  std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+  ZMath::float2 v;
+  v.x = distribution(random);
+  v.y = distribution(random);
+
+  return v;
+}
+
+/**
+ * Fills the given submeshes with random triangles referencing up to `numVertices` vertices.
+ */
+template <typename SubMesh>
+static void makeRandomTriangles(std::vector<SubMesh>& subMeshes, UINT32 numVertices,
+                                std::mt19937& random)
+{
+  const UINT32 numSubMeshes = 4;
+
+  subMeshes.resize(numSubMeshes);
+
+  for (UINT32 i = 0; i < numVertices; i++)
+  {
+    std::vector<uint32_t>& indices = subMeshes[i % numSubMeshes].indices;
+
+    indices.push_back(i);
+    indices.push_back(random() % numVertices);
+    indices.push_back(random() % numVertices);
+  }
+}
+
+static ZenLoad::PackedMesh makePackedMesh(UINT32 numVertices, std::mt19937& random)
+{
+  ZenLoad::PackedMesh mesh;
+  mesh.vertices.resize(numVertices);
+
+  for (ZenLoad::WorldVertex& v : mesh.vertices)
+  {
+    v.Position = randomFloat3(random, 100.0f);
+    v.Normal = randomFloat3(random, 1.0f);
+    v.TexCoord = randomFloat2(random);
+    v.Color = random();
+  }
+
+  makeRandomTriangles(mesh.subMeshes, numVertices, random);
+
+  return mesh;
+}
+
+static ZenLoad::PackedSkeletalMesh makePackedSkeletalMesh(UINT32 numVertices, UINT32 numBones,
+                                                          std::mt19937& random)
+{
+  ZenLoad::PackedSkeletalMesh mesh;
+  mesh.vertices.resize(numVertices);
+
+  for (ZenLoad::SkeletalVertex& v : mesh.vertices)
+  {
+    v.Normal = randomFloat3(random, 1.0f);
+    v.TexCoord = randomFloat2(random);
+    v.Color = random();
+
+    for (size_t i = 0; i < 4; i++)
+    {
+      v.LocalPositions[i] = randomFloat3(random, 1.0f);
+      v.BoneIndices[i] = (uint8_t)(random() % numBones);
+      v.Weights[i] = 0.25f;
+    }
+  }
+
+  makeRandomTriangles(mesh.subMeshes, numVertices, random);
+
+  return mesh;
+}
+
+static Vector<Matrix4> makeBindPose(UINT32 numBones, std::mt19937& random)
+{
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+  Vector<Matrix4> bindPose;
+
+  for (UINT32 i = 0; i < numBones; i++)
+  {
+    Vector3 position(distribution(random), distribution(random), distribution(random));
+    Quaternion rotation(Vector3::UNIT_Y, Radian(distribution(random) * Math::PI));
+
+    bindPose.push_back(Matrix4::TRS(position, rotation, Vector3::ONE));
+  }
+
+  return bindPose;
+}
+
+static std::vector<ZenLoad::ModelNode> makeNodes(UINT32 numNodes)
+{
+  std::vector<ZenLoad::ModelNode> nodes(numNodes);
+
+  for (UINT32 i = 0; i < numNodes; i++)
+  {
+    nodes[i].name = "BIP01 NODE " + std::to_string(i);
+    nodes[i].parentIndex = (i == 0) ? (uint16_t)-1 : (uint16_t)(i - 1);
+
+    for (UINT32 j = 0; j < 16; j++)
+    {
+      nodes[i].transformLocal.mv[j] = (j % 5 == 0) ? 1.0f : 0.0f;  // Identity
+    }
+  }
+
+  return nodes;
+}
+
+static std::vector<ZenLoad::zCModelAniSample> makeAnimationSamples(UINT32 numNodes,
+                                                                   UINT32 numFrames,
+                                                                   std::mt19937& random)
+{
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+  std::vector<ZenLoad::zCModelAniSample> samples(numNodes * numFrames);
+
+  for (ZenLoad::zCModelAniSample& sample : samples)
+  {
+    sample.position = randomFloat3(random, 1.0f);
+
+    Vector3 axis = Vector3::normalize(Vector3(distribution(random), distribution(random), 1.0f));
+    Quaternion rotation(axis, Radian(distribution(random) * Math::PI));
+
+    sample.rotation.x = rotation.x;
+    sample.rotation.y = rotation.y;
+    sample.rotation.z = rotation.z;
+    sample.rotation.w = rotation.w;
+  }
+
+  return samples;
+}
+
+// - Benchmarks ------------------------------------------------------------------------------------
+
+static void benchmarkTextures(const BenchOptions& options)
+{
+  std::mt19937 random(BENCH_SEED);
+
+  struct
+  {
+    const char* name;
+    ZTEXFormat format;
+  } formats[] = {
+      {"ImportTexture (DXT1)", ZTEXFormat::DXT1},
+      {"ImportTexture (DXT5)", ZTEXFormat::DXT5},
+      {"ImportTexture (A8R8G8B8)", ZTEXFormat::A8R8G8B8},
+      {"ImportTexture (R5G6B5)", ZTEXFormat::R5G6B5},
+      {"ImportTexture (P8)", ZTEXFormat::P8},
+  };
+
+  for (const auto& format : formats)
+  {
+    std::vector<uint8_t> ztex = makeZTEX(format.format, options.textureSize, random);
+
+    BenchResult result = runBenchmark(format.name, options.iterations, [&]() {
+      HTexture texture = BsZenLib::ImportTexture("BENCH.TGA", ztex);
+      return (bool)texture;
+    });
+
+    result.bytesIn = ztex.size();
+    result.items = (UINT64)options.textureSize * options.textureSize;
+    result.itemName = "texels";
+
+    printResult(result);
+  }
+}
+
+static void benchmarkStaticMesh(const BenchOptions& options)
+{
+  std::mt19937 random(BENCH_SEED);
+
+  ZenLoad::PackedMesh mesh = makePackedMesh(options.vertices, random);
+
+  BenchResult result = runBenchmark("ImportStaticMeshGeometry", options.iterations, [&]() {
+    HMesh imported = BsZenLib::ImportStaticMeshGeometry(mesh);
+    return (bool)imported;
+  });
+
+  result.bytesIn = mesh.vertices.size() * sizeof(ZenLoad::WorldVertex);
+  result.items = mesh.vertices.size();
+  result.itemName = "vertices";
+
+  printResult(result);
+
+  // Includes copying the mesh, as optimizing works in place
+  BenchResult optimize = runBenchmark("OptimizeVertexCache", options.iterations, [&]() {
+    ZenLoad::PackedMesh optimized = mesh;
+    BsZenLib::OptimizeVertexCache(optimized);
+    BsZenLib::OptimizeVertexFetch(optimized);
+    return !optimized.vertices.empty();
+  });
+
+  optimize.bytesIn = mesh.vertices.size() * sizeof(ZenLoad::WorldVertex);
+  optimize.items = mesh.vertices.size();
+  optimize.itemName = "vertices";
+
+  printResult(optimize);
+}
+
+static void benchmarkSkeletalMesh(const BenchOptions& options)
+{
+  std::mt19937 random(BENCH_SEED);
+
+  const UINT32 numBones = 64;
+
+  ZenLoad::PackedSkeletalMesh mesh = makePackedSkeletalMesh(options.vertices, numBones, random);
+  Vector<Matrix4> bindPose = makeBindPose(numBones, random);
+
+  BenchResult result = runBenchmark("ConvertSkeletalMeshData", options.iterations, [&]() {
+    return BsZenLib::ConvertSkeletalMeshData(mesh, bindPose) != nullptr;
+  });
+
+  result.bytesIn = mesh.vertices.size() * sizeof(ZenLoad::SkeletalVertex);
+  result.items = mesh.vertices.size();
+  result.itemName = "vertices";
+
+  printResult(result);
+}
+
+static void benchmarkAnimation(const BenchOptions& options)
+{
+  std::mt19937 random(BENCH_SEED);
+
+  // Roughly the size of the humans skeleton
+  const UINT32 numNodes = 64;
+
+  std::vector<ZenLoad::ModelNode> nodes = makeNodes(numNodes);
+  std::vector<ZenLoad::zCModelAniSample> samples =
+      makeAnimationSamples(numNodes, options.frames, random);
+
+  std::vector<uint32_t> nodeIndex;
+  for (UINT32 i = 0; i < numNodes; i++)
+  {
+    nodeIndex.push_back(i);
+  }
+
+  ZenLoad::zCModelAniHeader header = {};
+  header.numFrames = options.frames;
+  header.numNodes = numNodes;
+  header.fpsRate = 25.0f;
+
+  ZenLoad::zCModelScriptAni def = {};
+  def.m_Speed = 1.0f;
+
+  BenchResult result = runBenchmark("ConvertAnimationSamples", options.iterations, [&]() {
+    BsZenLib::AnimationCurvesWithRootMotion converted =
+        BsZenLib::ConvertAnimationSamples(nodes, def, header, nodeIndex, samples);
+
+    return !converted.curves.position.empty();
+  });
+
+  result.bytesIn = samples.size() * sizeof(ZenLoad::zCModelAniSample);
+  result.items = samples.size();
+  result.itemName = "samples";
+
+  printResult(result);
+}
+
+/**
+ * @return False, if one of the given kinds is unknown.
+ */
+static bool parseOnly(const String& kinds, BenchOptions& options)
+{
+  options.textures = false;
+  options.staticMeshes = false;
+  options.skeletalMeshes = false;
+  options.animations = false;
+
+  for (String kind : StringUtil::split(kinds, ","))
+  {
+    StringUtil::trim(kind);
+    StringUtil::toLowerCase(kind);
+
+    if (kind == "tex")
+    {
+      options.textures = true;
+    }
+    else if (kind == "mesh")
+    {
+      options.staticMeshes = true;
+    }
+    else if (kind == "skel")
+    {
+      options.skeletalMeshes = true;
+    }
+    else if (kind == "man")
+    {
+      options.animations = true;
+    }
+    else
+    {
+      std::cout << "Unknown benchmark: " << kind << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @return False, if the filter is unknown.
+ */
+static bool parseMipFilter(String filter, BsZenLib::TextureMipFilter& outFilter)
+{
+  StringUtil::toLowerCase(filter);
+
+  if (filter == "kaiser")
+  {
+    outFilter = BsZenLib::TextureMipFilter::Kaiser;
+  }
+  else if (filter == "box")
+  {
+    outFilter = BsZenLib::TextureMipFilter::Box;
+  }
+  else
+  {
+    std::cout << "Unknown mip-map filter: " << filter << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @return False, if the argument does not hold a positive number.
+ */
+static bool parsePositive(const String& arg, size_t prefixLength, UINT32& outValue)
+{
+  int value = atoi(arg.substr(prefixLength).c_str());
+
+  if (value <= 0)
+  {
+    std::cout << "Invalid value: " << arg << std::endl;
+    return false;
+  }
+
+  outValue = (UINT32)value;
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  BenchOptions options;
+
+  for (int i = 1; i < argc; i++)
+  {
+    String arg = argv[i];
+
+    if (arg == "--help" || arg == "-h")
+    {
+      printUsage();
+      return 0;
+    }
+    else if (StringUtil::startsWith(arg, "--iterations=", false))
+    {
+      if (!parsePositive(arg, 13, options.iterations)) return -1;
+    }
+    else if (StringUtil::startsWith(arg, "--texture-size=", false))
+    {
+      if (!parsePositive(arg, 15, options.textureSize)) return -1;
+    }
+    else if (StringUtil::startsWith(arg, "--vertices=", false))
+    {
+      if (!parsePositive(arg, 11, options.vertices)) return -1;
+    }
+    else if (StringUtil::startsWith(arg, "--frames=", false))
+    {
+      if (!parsePositive(arg, 9, options.frames)) return -1;
+    }
+    else if (StringUtil::startsWith(arg, "--only=", false))
+    {
+      if (!parseOnly(arg.substr(7), options)) return -1;
+    }
+    else if (StringUtil::startsWith(arg, "--mip-filter=", false))
+    {
+      if (!parseMipFilter(arg.substr(13), options.mipFilter)) return -1;
+    }
+    else
+    {
+      std::cout << "Unknown option: " << arg << std::endl;
+      printUsage();
+      return -1;
+    }
+  }
+
+  START_UP_DESC desc = Application::buildStartUpDesc(VideoMode(64, 64), "bszenlib-bench", false);
+  desc.renderAPI = "bsfNullRenderAPI";
+  desc.renderer = "bsfNullRenderer";
+  desc.audio = "bsfNullAudio";
+  desc.physics = "bsfNullPhysics";
+
+  Application::startUp(desc);
+
+  BsZenLib::SetTextureMipFilter(options.mipFilter);
+
+  std::cout << "Iterations: " << options.iterations << ", texture size: " << options.textureSize
+            << ", vertices: " << options.vertices << ", frames: " << options.frames << std::endl
+            << std::endl;
+
+  if (options.textures) benchmarkTextures(options);
+  if (options.staticMeshes) benchmarkStaticMesh(options);
+  if (options.skeletalMeshes) benchmarkSkeletalMesh(options);
+  if (options.animations) benchmarkAnimation(options);
+
+  Application::shutDown();
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+/** \file
+ * Pack all cached resources into a single, memory-mapped file
+ */
+
+#pragma once
+#include <BsCorePrerequisites.h>
+#include <Resources/BsResourceHandle.h>
+#include <Resources/BsResources.h>
+
+namespace BsZenLib
+{
+  /**
+   * Packs every cached resource (all `.asset`-files inside the cache directory) into a single
+   * file, `gothic-cache.pack`, next to the resource manifest.
+   *
+   * Loading a full cache file by file means opening tens of thousands of small files. With the
+   * pack mounted (see MountCachePack()), the LoadCached*-functions read from one memory-mapped
+   * file instead.
+   *
+   * The loose files are left alone. Only resources registered inside the saved resource
+   * manifest are packed, so call this after SaveResourceManifest(). Resources cached again later
+   * on are loaded from their loose files instead, so rebuild the pack after caching to get the
+   * benefit back.
+   *
+   * If a pack is currently mounted, it is unmounted first.
+   *
+   * @return False, if the pack could not be written.
+   */
+  bool BuildCachePack();
+
+  /**
+   * Memory-maps the pack built by BuildCachePack(), if there is one. Afterwards, the
+   * LoadCached*-functions will look inside the pack before going to the loose files.
+   *
+   * Call this once at startup, after LoadResourceManifest().
+   *
+   * @return False, if there is no pack or it is broken.
+   */
+  bool MountCachePack();
+
+  /**
+   * Unmaps the pack once all loads from it have finished. Resources already loaded from it stay
+   * loaded.
+   */
+  void UnmountCachePack();
+
+  /**
+   * @return Whether a pack is currently mounted.
+   */
+  bool IsCachePackMounted();
+
+  /**
+   * @return Whether the mounted pack contains the resource cached at the given path.
+   *         Always false if no pack is mounted.
+   */
+  bool HasPackedResource(const bs::Path& cachePath);
+
+  /**
+   * Loads the resource cached at the given path out of the mounted pack, along with all
+   * resources it depends on. Resources which are loaded already are not loaded again.
+   *
+   * @return The loaded resource. Empty handle if no pack is mounted, it does not contain the
+   *         resource or the resource has been cached again since the pack was built.
+   *
+   * @note This is threadsafe.
+   */
+  bs::HResource LoadPackedResource(const bs::Path& cachePath);
+
+  /**
+   * Loads a cached resource from the mounted pack, or from its own file if the pack does
+   * not contain it. This is what all LoadCached*-functions use.
+   */
+  template <typename T>
+  bs::ResourceHandle<T> LoadCachedResource(const bs::Path& cachePath)
+  {
+    bs::HResource packed = LoadPackedResource(cachePath);
+
+    if (packed) return bs::static_resource_cast<T>(packed);
+
+    return bs::gResources().load<T>(cachePath);
+  }
+
+}  // namespace BsZenLib
@@ -8,11 +8,104 @@ namespace VDFS
 
 namespace BsZenLib
 {
+  /**
+   * A file which could not be cached by CacheWholeVDFS().
+   */
+  struct CacheFailure
+  {
+    /** File inside the VDFS which failed to import (ie. "SHEEP.MDS") */
+    bs::String file;
+
+    /** What went wrong, as reported by the importer. */
+    bs::String reason;
+  };
+
+  /**
+   * Controls what CacheWholeVDFS() does.
+   */
+  struct CacheOptions
+  {
+    /**
+     * Maximum number of imports to run at once. 0 runs as many as the bs::f task scheduler
+     * has worker threads, which is usually the number of cores.
+     */
+    bs::UINT32 maxJobs = 0;
+
+    /** Whether to cache textures (.TEX) */
+    bool textures = true;
+
+    /** Whether to cache static meshes (.MRM) */
+    bool staticMeshes = true;
+
+    /** Whether to cache model scripts (.MDS) along with their meshes and animations */
+    bool modelScripts = true;
+
+    /** Whether to cache the world meshes of worlds (.ZEN) */
+    bool worlds = true;
+
+    /**
+     * Only check which files would need to be imported, without importing anything or
+     * writing to the cache. See GetOutdatedCacheFiles().
+     */
+    bool dryRun = false;
+
+    /**
+     * If set, import metrics are recorded while caching and written into this file as JSON
+     * afterwards. See SaveImportMetricsJSON().
+     */
+    bs::Path metricsFile;
+
+    /**
+     * If set, import metrics are recorded while caching and written into this file as Chrome
+     * trace afterwards. See SaveImportMetricsChromeTrace().
+     */
+    bs::Path traceFile;
+
+    /**
+     * Whether to pack the whole cache into a single file once caching is done, see
+     * BuildCachePack().
+     */
+    bool buildPack = false;
+  };
+
   /**
    * Will try to cache every file loaded into the given VDFS.
    *
+   * The files are imported in parallel using the bs::f task scheduler. Each asset is imported
+   * as soon as the assets it references are ready, ie. a material once its texture has been
+   * imported and a mesh once all its materials have been. Besides textures and static meshes,
+   * this also caches the world mesh of every ZEN and all model scripts. Once all of them are
+   * done, the resource manifest is saved.
+   *
+   * Files which have been cached before are only imported again if their original data
+   * inside the VDFS or the importer changed since then.
+   *
+   * A file failing to import does not stop the others from being cached, see GetCacheFailures().
+   * Model scripts which failed are put into quarantine and skipped by later calls until either
+   * the model script or the importer changes. To retry them anyways, delete
+   * `gothic-cache.quarantine` from the cache directory.
+   *
    * @param vdfs The VDFS to go through.
    */
   void CacheWholeVDFS(const VDFS::FileIndex& vdfs);
 
+  /**
+   * Like CacheWholeVDFS(), but lets you choose what to cache and how.
+   *
+   * @param vdfs    The VDFS to go through.
+   * @param options See CacheOptions.
+   */
+  void CacheWholeVDFS(const VDFS::FileIndex& vdfs, const CacheOptions& options);
+
+  /**
+   * @return Files which failed to import during the last call to CacheWholeVDFS().
+   */
+  bs::Vector<CacheFailure> GetCacheFailures();
+
+  /**
+   * @return Files which were missing or outdated in the cache during the last call to
+   *         CacheWholeVDFS(). On a dry run, these are the files which would have been imported.
+   */
+  bs::Vector<bs::String> GetOutdatedCacheFiles();
+
 }  // namespace BsZenLib
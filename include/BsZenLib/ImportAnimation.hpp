@@ -8,6 +8,7 @@
 #include <Animation/BsAnimationClip.h>
 #include <BsZenLib/ZenResources.hpp>
 #include <zenload/modelScriptParser.h>
+#include <zenload/zTypes.h>
 
 namespace ZenLoad
 {
@@ -60,6 +61,16 @@ namespace BsZenLib
     ZenLoad::zCModelScriptAniBlend animation;
   };
 
+  /**
+   * Keyframes of an animation converted for bs::f. The movement of the root node is kept apart
+   * so it can be applied to the model itself.
+   */
+  struct AnimationCurvesWithRootMotion
+  {
+    bs::AnimationCurves curves;
+    bs::RootMotion rootMotion;
+  };
+
   /**
    * Import a single animation clip.
    *
@@ -73,6 +84,24 @@ namespace BsZenLib
   Res::HZAnimation ImportMAN(const ZenLoad::zCModelMeshLib& meshLib, const AnimationToImport& def,
                              const VDFS::FileIndex& vdfs);
 
+  /**
+   * Converts the samples of a .MAN-file into animation curves, one per animated node. Nodes
+   * without samples are given a single keyframe holding their rest pose.
+   *
+   * This is one step of ImportMAN(). It does not touch the VDFS or the cache, so it is mostly
+   * useful for measuring the conversion on its own.
+   *
+   * @param nodes      Node hierarchy of the model, see zCModelMeshLib::getNodes().
+   * @param def        Definition of the animation inside the model script.
+   * @param header     Header of the .MAN-file.
+   * @param nodeIndex  Index into `nodes` for each node animated by the .MAN-file.
+   * @param samples    Samples of the .MAN-file, all nodes of frame 0 first, then frame 1, ...
+   */
+  AnimationCurvesWithRootMotion ConvertAnimationSamples(
+      const std::vector<ZenLoad::ModelNode>& nodes, const ZenLoad::zCModelScriptAni& def,
+      const ZenLoad::zCModelAniHeader& header, const std::vector<uint32_t>& nodeIndex,
+      const std::vector<ZenLoad::zCModelAniSample>& samples);
+
   /**
    * Alias a single animation clip and give it a different name and properties.
    *
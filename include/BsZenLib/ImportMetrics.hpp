@@ -0,0 +1,153 @@
+/** \file
+ * Timing and throughput of the single import stages
+ */
+
+#pragma once
+#include <BsCorePrerequisites.h>
+
+namespace BsZenLib
+{
+  /**
+   * One run of a single stage while importing an asset, ie. reading a texture from the VDFS.
+   */
+  struct ImportStageRecord
+  {
+    /** Kind of asset being imported (ie. "Texture") */
+    const char* assetType = "";
+
+    /** Stage of the import (ie. "ReadVDFS") */
+    const char* stage = "";
+
+    /** Name of the asset being imported (ie. "STONE.TGA") */
+    bs::String asset;
+
+    /** Start of the stage in microseconds, relative to when the first stage was recorded. */
+    bs::UINT64 startMicroseconds = 0;
+
+    /** Wall time spent in the stage, in microseconds. */
+    bs::UINT64 durationMicroseconds = 0;
+
+    /** Bytes the stage consumed. */
+    bs::UINT64 bytesIn = 0;
+
+    /** Bytes the stage produced. */
+    bs::UINT64 bytesOut = 0;
+
+    /** Small number identifying the thread the stage ran on, counting up from 1. */
+    bs::UINT32 threadId = 0;
+
+    /**
+     * Name of a quality the stage improves (ie. "ACMR"), or empty. Its value before and after
+     * the stage is reported next to the bytes.
+     */
+    const char* measure = "";
+    float measureBefore = 0.0f;
+    float measureAfter = 0.0f;
+  };
+
+  /**
+   * Sum of all records of one stage of one asset type.
+   */
+  struct ImportStageTotal
+  {
+    const char* assetType = "";
+    const char* stage = "";
+    bs::UINT64 count = 0;
+    bs::UINT64 durationMicroseconds = 0;
+    bs::UINT64 bytesIn = 0;
+    bs::UINT64 bytesOut = 0;
+  };
+
+  /**
+   * Measures the wall time from construction to destruction and records it as one stage of
+   * an import. Does nothing if metrics are disabled, see SetImportMetricsEnabled().
+   *
+   * Usage:
+   *
+   *     {
+   *       ScopedImportTimer timer("Texture", "ReadVDFS", name);
+   *       vdfs.getFileData(name, data);
+   *       timer.setBytesOut(data.size());
+   *     }
+   *
+   * @note The type and stage are expected to be string literals, they are not copied.
+   */
+  class ScopedImportTimer
+  {
+  public:
+    ScopedImportTimer(const char* assetType, const char* stage, const bs::String& asset);
+    ~ScopedImportTimer();
+
+    ScopedImportTimer(const ScopedImportTimer&) = delete;
+    ScopedImportTimer& operator=(const ScopedImportTimer&) = delete;
+
+    void setBytesIn(bs::UINT64 bytes) { mRecord.bytesIn = bytes; }
+    void setBytesOut(bs::UINT64 bytes) { mRecord.bytesOut = bytes; }
+
+    /**
+     * Records how the stage changed a quality of the asset. Only the records themselves carry
+     * it, as the totals of such values would mean nothing.
+     *
+     * @note The name is expected to be a string literal, it is not copied.
+     */
+    void setMeasure(const char* name, float before, float after)
+    {
+      mRecord.measure = name;
+      mRecord.measureBefore = before;
+      mRecord.measureAfter = after;
+    }
+
+    /**
+     * Sets the bytes produced to the size of the given file. Use this after saving a resource.
+     * Only looks at the file if metrics are enabled.
+     */
+    void setBytesOutFromFile(const bs::Path& file);
+
+  private:
+    ImportStageRecord mRecord;
+    bool mIsEnabled;
+  };
+
+  /**
+   * Enables or disables recording import metrics. Disabled by default.
+   *
+   * @note This is threadsafe, but stages already running when enabling won't be recorded.
+   */
+  void SetImportMetricsEnabled(bool enabled);
+
+  /**
+   * @return Whether import metrics are currently being recorded.
+   */
+  bool IsImportMetricsEnabled();
+
+  /**
+   * Throws away everything recorded so far.
+   */
+  void ResetImportMetrics();
+
+  /**
+   * @return Copy of everything recorded since the last reset.
+   */
+  bs::Vector<ImportStageRecord> GetImportStageRecords();
+
+  /**
+   * @return Recorded stages summed up by asset type and stage.
+   */
+  bs::Vector<ImportStageTotal> GetImportStageTotals();
+
+  /**
+   * Writes the totals and all single records into a JSON-file.
+   *
+   * @return False, if the file could not be written.
+   */
+  bool SaveImportMetricsJSON(const bs::Path& file);
+
+  /**
+   * Writes all records in the Chrome trace event format, which can be loaded into
+   * `chrome://tracing` or https://ui.perfetto.dev to see what ran when on which thread.
+   *
+   * @return False, if the file could not be written.
+   */
+  bool SaveImportMetricsChromeTrace(const bs::Path& file);
+
+}  // namespace BsZenLib
@@ -8,6 +8,7 @@ namespace BsZenLib
    */
   bs::Path GothicPathToCachedAsset(const bs::String& virtualFilePath);
   bs::Path GothicPathToCachedTexture(const bs::String& virtualFilePath);
+  bs::Path GothicPathToCachedTextureTail(const bs::String& virtualFilePath);
   bs::Path GothicPathToCachedMaterial(const bs::String& virtualFilePath);
   bs::Path GothicPathToCachedStaticMesh(const bs::String& virtualFilePath);
   bs::Path GothicPathToCachedSkeletalMesh(const bs::String& virtualFilePath);
@@ -17,6 +18,7 @@ namespace BsZenLib
   bs::Path GothicPathToCachedManifest(const bs::String& virtualFilePath);
   bs::Path GothicPathToCachedShader(const bs::String& shaderName);
   bs::Path GothicPathToCachedWorld(const bs::String& worldName);
+  bs::Path GothicPathToCachedWorldChunks(const bs::String& worldName);
   bs::Path GothicPathToCachedFont(const bs::String& virtualFilePath);
   bs::Path GetCacheDirectory();
 }  // namespace BsZenLib
@@ -7,6 +7,7 @@
 #include <Animation/BsSkeleton.h>
 #include <Material/BsMaterial.h>
 #include <Mesh/BsMesh.h>
+#include <Mesh/BsMeshData.h>
 #include <zenload/zCModelMeshLib.h>
 
 namespace ZenLoad
@@ -21,6 +22,20 @@ namespace VDFS
 
 namespace BsZenLib
 {
+  /**
+   * Version of the skeletal mesh importer, used for the CacheSourceStamp of cached model scripts.
+   *
+   * Bump this whenever the output of the skeletal mesh importer changes so caches get rebuilt.
+   */
+  constexpr bs::UINT32 SKELETAL_MESH_IMPORTER_VERSION = 3;
+
+  /**
+   * @return SKELETAL_MESH_IMPORTER_VERSION combined with whether texture streaming is enabled,
+   *         since the materials are cached along with the meshes. This is what the
+   *         CacheSourceStamp of cached model scripts is built with.
+   */
+  bs::UINT32 GetSkeletalMeshImporterVersion();
+
   /**
    * Imports a model script file.
    *
@@ -40,7 +55,8 @@ namespace BsZenLib
    *             and load that instead if it exists.
    * @param vdfs VDFS to load from.
    *
-   * @return Everything loaded from the given ModelScript-File.
+   * @return Everything loaded from the given ModelScript-File. Empty handle if the model script
+   *         or its hierarchy is broken. Meshes or animations failing to import are left out.
    */
   Res::HModelScriptFile ImportAndCacheMDS(const bs::String& mdsFile, const VDFS::FileIndex& vdfs);
 
@@ -55,6 +71,22 @@ namespace BsZenLib
   bs::Map<bs::String, Res::HMeshWithMaterials> ImportAndCacheNodeAttachments(
       const bs::String& mdlFile, const VDFS::FileIndex& vdfs);
 
+  /**
+   * Converts the vertices and indices of a skeletal mesh into the format used by the bs::f
+   * meshes created by ImportAndCacheMDS(). Vertex positions are moved into the given bind pose.
+   *
+   * This is one step of importing a model script. It does not touch the GPU or the cache, so it
+   * is mostly useful for measuring the conversion on its own.
+   *
+   * @param packedMesh  Mesh to convert.
+   * @param bindPose    Object space transforms of the bones, as indexed by the vertices.
+   *
+   * @return Mesh data to be written into a bs::Mesh with a matching MESH_DESC. Its indices are
+   *         16-bit if the mesh has few enough vertices, see ChooseIndexType().
+   */
+  bs::SPtr<bs::MeshData> ConvertSkeletalMeshData(const ZenLoad::PackedSkeletalMesh& packedMesh,
+                                                 const bs::Vector<bs::Matrix4>& bindPose);
+
   /**
    * Whether the given .MDS-file has been cached.
    *
@@ -65,6 +97,21 @@ namespace BsZenLib
    */
   bool HasCachedMDS(const bs::String& mdsFile);
 
+  /**
+   * Whether the given .MDS-file has been cached and is still up to date.
+   *
+   * Other than HasCachedMDS(), this also checks whether the model script inside the VDFS
+   * and the importer are still the same as when the cache was created. Only the model
+   * script itself is checked, not the meshes and animations it references.
+   *
+   * @param mdsfile .MDS-file to look after. Always supply the .MDS-file, even when
+   *                a matching .MSB-file exists!
+   * @param vdfs    VDFS containing the model script.
+   *
+   * @return Whether an up to date cache exists for the .MDS-file.
+   */
+  bool HasCachedMDS(const bs::String& mdsFile, const VDFS::FileIndex& vdfs);
+
   /**
    * Loads a .MDS-file from cache.
    *
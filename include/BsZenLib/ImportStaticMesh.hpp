@@ -6,6 +6,7 @@
 #include <Material/BsMaterial.h>
 #include <Components/BsCRenderable.h>
 #include <Mesh/BsMesh.h>
+#include "ResourceManifest.hpp"
 #include "ZenResources.hpp"
 
 namespace ZenLoad
@@ -21,6 +22,74 @@ namespace VDFS
 
 namespace BsZenLib
 {
+	/**
+	 * Version of the static mesh importer, used for the CacheSourceStamp of cached meshes.
+	 * 
+	 * Bump this whenever the output of the static mesh importer changes so caches get rebuilt.
+	 */
+	constexpr bs::UINT32 STATIC_MESH_IMPORTER_VERSION = 3;
+
+	/**
+	 * Layout of the vertices of imported static meshes.
+	 */
+	enum class StaticMeshVertexFormat
+	{
+		/**
+		 * Float normals plus a float tangent with its handedness in `w`, 52 bytes per vertex.
+		 * The tangent is zero unless a material of the mesh needs it, see MaterialNeedsTangents().
+		 */
+		Full,
+
+		/**
+		 * Normals packed into 4 bytes, 28 bytes per vertex. Positions and texture coordinates
+		 * stay full floats, so bounds and physics meshes are unaffected. A tangent packed the
+		 * same way is only added if a material of the mesh needs it, making it 32 bytes.
+		 */
+		Compact,
+	};
+
+	/**
+	 * Sets the layout of the vertices of static meshes imported from now on, including world
+	 * meshes. Defaults to StaticMeshVertexFormat::Full.
+	 *
+	 * Changing this makes all cached static meshes outdated, see HasCachedStaticMesh().
+	 *
+	 * @note This is threadsafe, but imports already running keep the format they started with.
+	 */
+	void SetStaticMeshVertexFormat(StaticMeshVertexFormat format);
+
+	/**
+	 * @return Layout of the vertices of static meshes imported from now on.
+	 */
+	StaticMeshVertexFormat GetStaticMeshVertexFormat();
+
+	/**
+	 * Sets whether static meshes imported from now on are optimized for the GPU: Triangles are
+	 * reordered for the vertex cache, then vertices for fetching them in order, see
+	 * OptimizeVertexCache() and OptimizeVertexFetch(). This is done once while caching, so it
+	 * costs nothing at runtime. Disabled by default.
+	 *
+	 * With import metrics enabled, the `OptimizeMesh` stage reports the ACMR of every mesh
+	 * before and after, see ComputeACMR().
+	 *
+	 * Changing this makes all cached static meshes outdated, see HasCachedStaticMesh().
+	 *
+	 * @note This is threadsafe, but imports already running keep the setting they started with.
+	 */
+	void SetStaticMeshOptimization(bool enabled);
+
+	/**
+	 * @return Whether static meshes imported from now on are optimized for the GPU.
+	 */
+	bool GetStaticMeshOptimization();
+
+	/**
+	 * @return STATIC_MESH_IMPORTER_VERSION combined with the current import settings, including
+	 *         whether texture streaming is enabled. This is what the CacheSourceStamp of cached
+	 *         static meshes is built with.
+	 */
+	bs::UINT32 GetStaticMeshImporterVersion();
+
 	/**
 	 * Checks whether the given static mesh has been cached.
 	 * 
@@ -30,6 +99,20 @@ namespace BsZenLib
 	 */
 	bool HasCachedStaticMesh(const bs::String& originalFileName);
 
+	/**
+	 * Checks whether the given static mesh has been cached and is still up to date.
+	 * 
+	 * Other than HasCachedStaticMesh(), this also checks whether the compiled mesh inside the
+	 * VDFS and the importer are still the same as when the cache was created. If the mesh
+	 * does not exist inside the VDFS, the cache can't be checked and is assumed to be fine.
+	 * 
+	 * @param orignalFileName  Name of the file in the original game (eg. "STONE.3DS")
+	 * @param vdfs             VDFS containing the original file.
+	 * 
+	 * @return True, if an up to date cache exists. False otherwise.
+	 */
+	bool HasCachedStaticMesh(const bs::String& originalFileName, const VDFS::FileIndex& vdfs);
+
 	/**
 	 * Loads the cached version representing the given original file.
 	 * 
@@ -66,6 +149,24 @@ namespace BsZenLib
 	 */
 	Res::HMeshWithMaterials ImportAndCacheStaticMesh(const bs::String& originalFileName, const ZenLoad::PackedMesh& packedMesh, const VDFS::FileIndex& vdfs);
 
+	/**
+	 * Imports and caches a static mesh from custom mesh data, using materials which have
+	 * already been imported, for example via ImportAndCacheMaterialWithTextures().
+	 * 
+	 * The cached mesh is registered with the given stamp, see HasCachedStaticMesh().
+	 * 
+	 * @param originalFileName Name of the static mesh in the original game (eg. "STONE.3DS")
+	 * @param packedMesh       Custom mesh data.
+	 * @param materials        Materials to use, one for each submesh of the packed mesh.
+	 * @param stamp            Identifies the original data the mesh was built from.
+	 * 
+	 * @return Handle to the imported mesh (Empty if unsuccessfull)
+	 */
+	Res::HMeshWithMaterials ImportAndCacheStaticMesh(const bs::String& originalFileName,
+	                                                 const ZenLoad::PackedMesh& packedMesh,
+	                                                 const bs::Vector<bs::HMaterial>& materials,
+	                                                 const CacheSourceStamp& stamp);
+
 	/**
 	 * Imports and caches only the geometry of a static mesh (.3DS) from the original game.
 	 * 
@@ -81,15 +182,20 @@ namespace BsZenLib
 	 * 
 	 * @param originalFileName Name of the static mesh in the original game (eg. "STONE.3DS")
 	 * @param packedMesh       Custom mesh data.
+	 * @param withTangents     Whether to generate tangents, see GenerateTangents().
 	 * 
 	 * @return Handle to the imported mesh (Empty if unsuccessfull)
 	 */
-	bs::HMesh ImportAndCacheStaticMeshGeometry(const bs::String& originalFileName, const ZenLoad::PackedMesh& packedMesh);
+	bs::HMesh ImportAndCacheStaticMeshGeometry(const bs::String& originalFileName, const ZenLoad::PackedMesh& packedMesh,
+	                                           bool withTangents = false);
 
 
 	/**
 	 * Imports and caches only the materials of a static mesh (.3DS) from the original game.
 	 * 
+	 * Materials belong to exactly one mesh, so they are always imported again, even if they
+	 * have been cached before.
+	 * 
 	 * @note This will also cache Textures.
 	 * 
 	 * @param originalFileName Name of the static mesh in the original game (eg. "STONE.3DS")
@@ -116,9 +222,10 @@ namespace BsZenLib
 	 * Imports only the geometry from custom mesh data without caching it.
 	 * 
 	 * @param packedMesh       Custom mesh data.
+	 * @param withTangents     Whether to generate tangents, see GenerateTangents().
 	 * 
 	 * @return Handle to the imported mesh (Empty if unsuccessfull)
 	 */
 
-  bs::HMesh ImportStaticMeshGeometry(const ZenLoad::PackedMesh& packedMesh);
+  bs::HMesh ImportStaticMeshGeometry(const ZenLoad::PackedMesh& packedMesh, bool withTangents = false);
 }  // namespace BsZenLib
@@ -4,6 +4,9 @@
 
 #pragma once
 #include <string>
+#include <vector>
+#include "TextureCompression.hpp"
+#include "TextureMipMaps.hpp"
 #include <Image/BsTexture.h>
 
 namespace VDFS
@@ -33,6 +36,19 @@ namespace BsZenLib
    */
   bs::HTexture ImportTexture(const bs::String& virtualFilePath, const VDFS::FileIndex& vdfs);
 
+  /**
+   * Import a Gothic zTEX-Texture which has already been read into memory, without saving the
+   * results to disk.
+   *
+   * See also ImportTexture().
+   *
+   * @param name      Name to give the texture, only used for logging and metrics.
+   * @param ztexData  Contents of a compiled .TEX-file.
+   *
+   * @return BsTexture containing the Data from the Gothic zTEX. Empty handle if importing failed.
+   */
+  bs::HTexture ImportTexture(const bs::String& name, const std::vector<uint8_t>& ztexData);
+
   /**
    * Import a Gothic zTEX-Texture and save the results to disk.
    *
@@ -50,6 +66,42 @@ namespace BsZenLib
   bs::HTexture ImportAndCacheTexture(const bs::String& originalFileName,
                                      const VDFS::FileIndex& vdfs);
 
+  /**
+   * Options for ImportAndCacheTextures().
+   */
+  struct TextureBatchOptions
+  {
+    /**
+     * Whether to load textures with an up to date cache from it instead of importing them
+     * again, see HasCachedTexture().
+     */
+    bool reuseCached = true;
+
+    /**
+     * Maximum number of textures to import at once. 0 runs as many as the bs::f task scheduler
+     * has worker threads.
+     */
+    bs::UINT32 maxJobs = 0;
+  };
+
+  /**
+   * Import several Gothic zTEX-Textures at once and save the results to disk.
+   *
+   * Same as calling ImportAndCacheTexture() for each of them, but the textures are imported in
+   * parallel on the bs::f task scheduler, with each worker reusing its buffer for reading from
+   * the VDFS. Names listed more than once are only imported once.
+   *
+   * @param originalFileNames  Names of the textures in the original games files.
+   * @param vdfs               Virtual Filesystem to load the textures from.
+   * @param options            See TextureBatchOptions.
+   *
+   * @return One handle per given name, in the same order. Empty handles for textures which
+   *         failed to import.
+   */
+  bs::Vector<bs::HTexture> ImportAndCacheTextures(const bs::Vector<bs::String>& originalFileNames,
+                                                  const VDFS::FileIndex& vdfs,
+                                                  const TextureBatchOptions& options = {});
+
   /**
    * Load a cached Texture from disk using the original texture name.
    *
@@ -67,10 +119,67 @@ namespace BsZenLib
   /**
    * Checks whether the cache for the given original texture name exists.
    *
+   * Only looks at the texture index (see FindCachedTextureInfo()) and whether the cached file is
+   * registered inside the resource manifest or cache pack. All of them are kept in memory, so
+   * this is cheap enough to be called before every load. Textures cached by an
+   * older importer don't count, the settings they were imported with don't matter.
+   *
    * To create the cache, call ImportAndCacheTexture().
    *
    * @param originalFileName  Name of the texture in the original games files (ie. "STONE.TGA")
    * @return Whether the cache exists for the given texture.
    */
   bool HasCachedTexture(const bs::String& originalFileName);
+
+  /**
+   * Checks whether the cache for the given original texture name exists and is still up to date.
+   *
+   * Other than HasCachedTexture(), this also checks whether the compiled texture inside the
+   * VDFS and the importer settings are still the same as when the cache was created. The
+   * compiled texture has to be read and hashed for that, which is about as slow as importing it,
+   * so only use this while caching. If the texture does not exist inside the VDFS, the cache
+   * can't be checked and is assumed to be fine.
+   *
+   * @param originalFileName  Name of the texture in the original games files (ie. "STONE.TGA")
+   * @param vdfs              Virtual Filesystem to load the texture from.
+   *
+   * @return Whether an up to date cache exists for the given texture.
+   */
+  bool HasCachedTexture(const bs::String& originalFileName, const VDFS::FileIndex& vdfs);
+
+  /**
+   * Sets the filter used to generate the mip-maps of uncompressed textures. Compressed textures
+   * bring their own mip-maps. Defaults to TextureMipFilter::Kaiser.
+   *
+   * Changing the filter makes the cached textures imported from uncompressed ones outdated, see
+   * HasCachedTexture().
+   *
+   * @note This is threadsafe, but imports already running keep the filter they started with.
+   */
+  void SetTextureMipFilter(TextureMipFilter filter);
+
+  /**
+   * @return Filter used to generate the mip-maps of uncompressed textures.
+   */
+  TextureMipFilter GetTextureMipFilter();
+
+  /**
+   * Sets whether textures the game stores uncompressed are block compressed while importing,
+   * and how much time the encoder may spend on it. Textures which are compressed already are
+   * left as they are. Defaults to no compression.
+   *
+   * Compressing shrinks both the cache on disk and the memory the textures take up at runtime,
+   * but makes importing a lot slower, especially with BC7.
+   *
+   * Changing this makes the cached textures imported from uncompressed ones outdated, see
+   * HasCachedTexture(). The quality only counts while compression is turned on.
+   *
+   * @note This is threadsafe, but imports already running keep the settings they started with.
+   */
+  void SetTextureCompression(const TextureCompressionOptions& options);
+
+  /**
+   * @return How textures the game stores uncompressed are compressed while importing.
+   */
+  TextureCompressionOptions GetTextureCompression();
 }  // namespace BsZenLib
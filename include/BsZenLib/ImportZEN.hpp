@@ -12,4 +12,15 @@ namespace BsZenLib
 	bool HasCachedZEN(const bs::String& zen);
 	bs::HSceneObject ImportZEN(const std::string& zen, const VDFS::FileIndex& vdfs);
 	bs::HSceneObject ImportAndCacheZEN(const std::string& zen, const VDFS::FileIndex& vdfs);
+
+	/**
+	 * Requests the full resolution textures of all materials inside the given world, nearest to
+	 * the given position first. Call this again whenever the viewer has moved far enough to
+	 * update the priorities. See RequestMaterialDetail().
+	 *
+	 * ImportZEN() already does this from the origin of the world if texture streaming is enabled.
+	 * Chunks of a world split by SetWorldChunkSize() have no meshes until they are loaded, so
+	 * UpdateWorldChunks() requests their textures instead.
+	 */
+	void RequestWorldTextureDetail(const bs::HSceneObject& world, const bs::Vector3& viewPosition);
 }  // namespace BsZenLib
@@ -0,0 +1,51 @@
+/** \file
+ * Deduplicate imports of the same asset running at the same time
+ */
+
+#pragma once
+#include <functional>
+#include <BsCorePrerequisites.h>
+#include <Resources/BsResourceHandle.h>
+
+namespace BsZenLib
+{
+  /**
+   * Runs an import of the resource to be cached at the given path, unless another thread is
+   * already importing it. In that case, this waits for the other import to finish and returns
+   * its result instead of importing the resource a second time.
+   *
+   * All ImportAndCache*-functions go through this, so whenever two import tasks need the same
+   * asset (ie. two meshes sharing a texture), only one of them does the actual work.
+   *
+   * Calling this again for the same path from within the import function runs the inner import
+   * right away, as the thread would otherwise be waiting for itself.
+   *
+   * Once an import has finished, it is forgotten. Later calls for the same path will import
+   * again, so use the HasCached*-functions inside the import function to skip work that has
+   * been done already.
+   *
+   * @param cachePath  Path the imported resource is cached at, identifies the import.
+   * @param import     Does the actual importing and caching.
+   *
+   * @return Result of the import, either from this thread or the one which was faster.
+   *
+   * @note This is threadsafe. Exceptions thrown by the import are rethrown to all waiting threads.
+   */
+  bs::HResource ImportOnce(const bs::Path& cachePath, const std::function<bs::HResource()>& import);
+
+  /**
+   * Typed version of ImportOnce(), ie.
+   *
+   *     HTexture texture = ImportOnce<Texture>(path, [&]() { return importTexture(); });
+   */
+  template <typename T>
+  bs::ResourceHandle<T> ImportOnce(const bs::Path& cachePath,
+                                   const std::function<bs::ResourceHandle<T>()>& import)
+  {
+    bs::HResource imported =
+        ImportOnce(cachePath, [&]() -> bs::HResource { return import(); });
+
+    return bs::static_resource_cast<T>(imported);
+  }
+
+}  // namespace BsZenLib
@@ -0,0 +1,150 @@
+/** \file
+ * Read and write the small text files kept inside the cache directory
+ */
+
+#pragma once
+#include <fstream>
+#include <BsCorePrerequisites.h>
+
+namespace BsZenLib
+{
+  /**
+   * Builds the contents of a line record file.
+   *
+   * Every record is a single line of fields separated by spaces, optionally ending with a text
+   * which may contain spaces itself, ie. a path:
+   *
+   *     LineRecordWriter records;
+   *     records.write(stamp.sourceHash);
+   *     records.write(stamp.importerVersion);
+   *     records.endRecord(relativePath);
+   *
+   * Stamps, journal, texture index, quarantine list and chunk indices are all written this way,
+   * see LineRecordReader for reading them back.
+   */
+  class LineRecordWriter
+  {
+  public:
+    void write(bs::UINT64 value);
+    void write(bs::UINT32 value);
+
+    /** Written with enough digits to be read back exactly. */
+    void write(float value);
+
+    /** Words must neither contain spaces nor line breaks. */
+    void write(const bs::String& word);
+
+    /**
+     * Ends the current record with the given text, which may contain spaces but no line breaks.
+     */
+    void endRecord(const bs::String& text = "");
+
+    /**
+     * Writes all records into the given file, replacing it.
+     *
+     * @return False, if the file could not be written.
+     */
+    bool save(const bs::Path& path) const;
+
+    const bs::String& getContents() const { return mContents; }
+    bool isEmpty() const { return mContents.empty(); }
+    void clear() { mContents.clear(); }
+
+  private:
+    bs::String mContents;
+  };
+
+  /**
+   * Appends records to the end of a file, which is opened on first use and kept open.
+   *
+   * Records are flushed right away, which hands them to the OS, so they survive the process
+   * crashing. A record cut off while writing is missing its line break and is skipped by
+   * LineRecordReader.
+   *
+   * @note Not threadsafe, guard it with the mutex of whatever it journals.
+   */
+  class LineRecordAppender
+  {
+  public:
+    /**
+     * @return False, if the file could not be opened.
+     */
+    bool append(const bs::Path& path, const LineRecordWriter& records);
+
+    /**
+     * Closes the file, ie. before replacing or removing it. Appending opens it again.
+     */
+    void close();
+
+  private:
+    std::ofstream mFile;
+  };
+
+  /**
+   * Reads a file written by LineRecordWriter or LineRecordAppender, one record at a time:
+   *
+   *     LineRecordReader records;
+   *     if (!records.open(path)) return;
+   *
+   *     while (records.nextRecord())
+   *     {
+   *       if (!records.read(stamp.sourceHash) || !records.read(stamp.importerVersion)) continue;
+   *
+   *       String relativePath = records.readRest();
+   *     }
+   */
+  class LineRecordReader
+  {
+  public:
+    /**
+     * Reads the whole file into memory.
+     *
+     * @return False, if the file does not exist or could not be read.
+     */
+    bool open(const bs::Path& path);
+
+    /**
+     * Moves on to the next record. A last line without line break has been cut off while
+     * writing it and does not count.
+     *
+     * @return False, if there are no records left.
+     */
+    bool nextRecord();
+
+    /**
+     * Reads the next field of the current record.
+     *
+     * @return False, if the record has no fields left or the field is not of the given type.
+     *         Reading further fields of that record is pointless then.
+     */
+    bool read(bs::UINT64& outValue);
+    bool read(bs::UINT32& outValue);
+    bool read(float& outValue);
+    bool read(bs::String& outWord);
+
+    /**
+     * @return The text ending the current record, without surrounding whitespace.
+     */
+    bs::String readRest();
+
+    /**
+     * @return Whether the file ends with a line cut off while writing it. Only known once
+     *         nextRecord() returned false.
+     */
+    bool hasCutOffRecord() const { return mNextLine < mContents.size(); }
+
+  private:
+    /**
+     * Moves the cursor past the field ending at the given position.
+     *
+     * @return False, if the field is not followed by a space or the end of the record.
+     */
+    bool skipField(const char* fieldEnd);
+
+    bs::String mContents;
+    size_t mNextLine = 0;
+    const char* mCursor = nullptr;
+    const char* mRecordEnd = nullptr;
+  };
+
+}  // namespace BsZenLib
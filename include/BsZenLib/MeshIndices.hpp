@@ -0,0 +1,30 @@
+/** \file
+ * Pick and fill the index buffers of imported meshes
+ */
+
+#pragma once
+#include <cstddef>
+#include <BsCorePrerequisites.h>
+#include <RenderAPI/BsIndexBuffer.h>
+
+namespace BsZenLib
+{
+  /**
+   * @return IT_16BIT for meshes with fewer than 65536 vertices, IT_32BIT otherwise. The index
+   *         0xFFFF is left unused, as some APIs reserve it to restart strips.
+   *
+   * Almost all meshes of the game stay below that, so this halves the memory and bandwidth
+   * their indices take. Mostly world meshes need 32-bit indices.
+   */
+  bs::IndexType ChooseIndexType(bs::UINT32 numVertices);
+
+  /**
+   * Copies 32-bit indices into a 16-bit index buffer, 8 at a time using SSE2 where available.
+   *
+   * @param src    Indices to narrow. All of them must be below 65536.
+   * @param dst    Receives the narrowed indices. Must not overlap with `src`.
+   * @param count  Number of indices.
+   */
+  void NarrowIndices(const bs::UINT32* src, bs::UINT16* dst, size_t count);
+
+}  // namespace BsZenLib
@@ -0,0 +1,54 @@
+/** \file
+ * Reorder triangles and vertices of meshes for faster rendering
+ */
+
+#pragma once
+#include <BsCorePrerequisites.h>
+
+namespace ZenLoad
+{
+  struct PackedMesh;
+}
+
+namespace BsZenLib
+{
+  /**
+   * Size of the FIFO vertex cache simulated by ComputeACMR(). Small enough to be a safe guess
+   * for most GPUs, see the Tipsify paper.
+   */
+  constexpr bs::UINT32 ACMR_CACHE_SIZE = 16;
+
+  /**
+   * Computes the average cache miss ratio of the given mesh: How many vertices need to be
+   * transformed per triangle, if the GPU keeps the last transformed vertices in a FIFO cache.
+   *
+   * 3 is the worst possible value, 0.5 is about the best a large regular grid can get. Every
+   * submesh is drawn on its own, so the cache starts out empty for each of them.
+   *
+   * @param packedMesh  Mesh to measure.
+   * @param cacheSize   Number of vertices the simulated cache holds.
+   *
+   * @return Average cache miss ratio, or 0 if the mesh has no triangles.
+   */
+  float ComputeACMR(const ZenLoad::PackedMesh& packedMesh,
+                    bs::UINT32 cacheSize = ACMR_CACHE_SIZE);
+
+  /**
+   * Reorders the triangles inside every submesh so they reuse vertices which have just been
+   * transformed, using Tom Forsyth's "Linear-Speed Vertex Cache Optimisation". Submeshes are
+   * processed in parallel on the bs::f task scheduler.
+   *
+   * The vertices themselves are not touched, see OptimizeVertexFetch().
+   */
+  void OptimizeVertexCache(ZenLoad::PackedMesh& packedMesh);
+
+  /**
+   * Reorders the vertices of the mesh into the order the indices first use them in, so the GPU
+   * reads the vertex buffer front to back. Indices are updated to match. Vertices not used by
+   * any triangle are kept, after all used ones.
+   *
+   * Run this after OptimizeVertexCache(), as it depends on the order of the triangles.
+   */
+  void OptimizeVertexFetch(ZenLoad::PackedMesh& packedMesh);
+
+}  // namespace BsZenLib
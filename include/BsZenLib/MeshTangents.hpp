@@ -0,0 +1,46 @@
+/** \file
+ * Generate tangents for normal mapping
+ */
+
+#pragma once
+#include <BsCorePrerequisites.h>
+#include <Material/BsMaterial.h>
+#include <Math/BsVector4.h>
+
+namespace ZenLoad
+{
+  struct PackedMesh;
+}
+
+namespace BsZenLib
+{
+  /**
+   * Name of the material parameter holding the normal map, as used by the bs::f standard shader.
+   */
+  constexpr const char* NORMAL_MAP_PARAM = "gNormalTex";
+
+  /**
+   * Whether meshes drawn with the given material need tangents, which is the case if the
+   * material has a normal map other than the flat default one of bs::f.
+   *
+   * None of the materials of the original game have normal maps, so this only becomes true
+   * if one is set on the material later on, ie. by a shader set using SetShaderFor().
+   */
+  bool MaterialNeedsTangents(const bs::HMaterial& material);
+
+  /**
+   * Generates a tangent for every vertex of the given mesh, in the spirit of MikkTSpace: Every
+   * triangle contributes the direction of its texture coordinates to its corners, weighted by
+   * the angle at the corner. The sums are then made orthogonal to the vertex normals.
+   *
+   * The triangles of each submesh are processed in parallel on the bs::f task scheduler. This
+   * may be called from within a task.
+   *
+   * @param packedMesh   Mesh to generate the tangents for.
+   * @param outTangents  Receives one tangent per vertex. `w` is the handedness of the tangent
+   *                     space (1 or -1), so `bitangent = cross(normal, tangent) * w`.
+   */
+  void GenerateTangents(const ZenLoad::PackedMesh& packedMesh,
+                        bs::Vector<bs::Vector4>& outTangents);
+
+}  // namespace BsZenLib
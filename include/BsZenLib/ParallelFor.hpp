@@ -0,0 +1,28 @@
+/** \file
+ * Split work into ranges running on the bs::f task scheduler
+ */
+
+#pragma once
+#include <functional>
+#include <BsCorePrerequisites.h>
+
+namespace BsZenLib
+{
+  /**
+   * Splits the items `[0, count)` into ranges of `minPerRange` items and runs the given function
+   * on all of them in parallel, using the bs::f task scheduler. The calling thread works on the
+   * first range itself, then waits for the others. If everything fits into a single range, no
+   * task is created at all.
+   *
+   * Waiting lends the calling thread's core to the task scheduler, so this may be called from
+   * within a task, ie. while importing.
+   *
+   * @param count        Number of items.
+   * @param minPerRange  Items to put into one range, so the work of a range outweighs the
+   *                     overhead of a task.
+   * @param work         Called with the first and one past the last item of a range.
+   */
+  void ParallelFor(bs::UINT32 count, bs::UINT32 minPerRange,
+                   const std::function<void(bs::UINT32, bs::UINT32)>& work);
+
+}  // namespace BsZenLib
@@ -1,16 +1,50 @@
 #pragma once
 #include <BsPrerequisites.h>
 
+namespace VDFS
+{
+  class FileIndex;
+}
+
 namespace BsZenLib
 {
+  /**
+   * Identifies the exact original data a cached resource was built from.
+   *
+   * If either the bytes of the original file or the importer producing the cached
+   * resource changes, the stamp won't match anymore and the resource needs to be
+   * imported again.
+   */
+  struct CacheSourceStamp
+  {
+    /** Hash of the original files bytes, see HashSourceData(). */
+    bs::UINT64 sourceHash = 0;
+
+    /** Version of the importer which created the cached resource. */
+    bs::UINT32 importerVersion = 0;
+
+    bool operator==(const CacheSourceStamp& other) const
+    {
+      return sourceHash == other.sourceHash && importerVersion == other.importerVersion;
+    }
+
+    bool operator!=(const CacheSourceStamp& other) const { return !(*this == other); }
+  };
+
   /**
    * Loads a resource manifest written by a previous cache operation which
    * lists all cached original gothic assets.
    *
    * If none exists, nothing happens.
    *
+   * Registrations which were journaled but not saved into the manifest, ie. because the
+   * previous run crashed, are replayed and the manifest is saved right away.
+   *
    * For information about resource manifests, see:
    * https://www.bsframework.io/docs/saving_scene.html
+   *
+   * @note Replaces the currently loaded manifest, so only call this during the init-phase
+   *       and not while caching is in progress.
    */
   void LoadResourceManifest();
 
@@ -18,26 +52,89 @@ namespace BsZenLib
    * Adds the given resource to the resource manifest used for caching the
    * original gothic assets.
    *
-   * This will also save the manifest automatically to circumvent issues
-   * when a crash happens during caching time.
+   * Registrations are kept in memory until SaveResourceManifest() is called, which
+   * flushes them into the manifest and writes it to disk. They are also appended to a
+   * journal inside the cache directory in batches of 4 per manifest shard, so a crash before
+   * that loses at most 3 registrations per shard, 192 in total. See LoadResourceManifest() and
+   * FlushResourceManifestJournal().
    *
-   * @note This is not threadsave!
+   * @note This is threadsafe and can be called from multiple import tasks at once.
    */
   void AddToResourceManifest(bs::HResource resource, const bs::Path& filePath);
 
   /**
-   * Saves the resource manifest to disk.
+   * Like AddToResourceManifest(), but also records which original data the resource
+   * was built from. See HasCachedResource() on how to check against it.
+   *
+   * @note This is threadsafe and can be called from multiple import tasks at once.
+   */
+  void AddToResourceManifest(bs::HResource resource, const bs::Path& filePath,
+                             const CacheSourceStamp& stamp);
+
+  /**
+   * Flushes all pending registrations into the manifest and saves it to disk. Afterwards,
+   * the journal of registrations is emptied as everything in it is part of the manifest now.
    *
    * If no resource manifest has been loaded, yet, an empty one will be created
    * and saved. Be careful as this will replace the existing manfest should none exist!
    *
    * Also note that saving a manifest is rather slow so don't call this too often.
+   * It must not be called while import tasks are still running, do it once after
+   * all of them have finished.
    */
   void SaveResourceManifest();
 
+  /**
+   * Writes registrations still waiting for their batch into the journal, so the next
+   * LoadResourceManifest() replays them. Call this before shutting down if resources were
+   * cached since the last SaveResourceManifest(), which makes it unnecessary.
+   *
+   * @note This is threadsafe.
+   */
+  void FlushResourceManifestJournal();
+
   /**
    * @return Whether the given resource was cached and saved to the manifest before.
+   *
+   * @note This is threadsafe and does not block on concurrent calls to AddToResourceManifest().
    */
   bool HasCachedResource(const bs::Path& filePath);
 
+  /**
+   * @return Whether the given resource was cached before *and* has been built from
+   *         the original data identified by the given stamp. Resources registered
+   *         without a stamp never match.
+   *
+   * @note This is threadsafe.
+   */
+  bool HasCachedResource(const bs::Path& filePath, const CacheSourceStamp& stamp);
+
+  /**
+   * Looks up the UUID the given cached resource is registered under, including registrations
+   * which have not been saved yet. Caching a resource again registers it under a new UUID.
+   *
+   * @return False, if the resource is not registered.
+   *
+   * @note This is threadsafe and only looks at what is kept in memory.
+   */
+  bool FindCachedResourceUUID(const bs::Path& filePath, bs::UUID& outUUID);
+
+  /**
+   * Hashes the bytes of an original file to be used as CacheSourceStamp::sourceHash.
+   */
+  bs::UINT64 HashSourceData(const bs::UINT8* data, size_t size);
+
+  /**
+   * Builds the stamp for a resource imported from the given original file.
+   *
+   * @param originalFile     File inside the VDFS the resource is imported from (ie. "STONE-C.TEX")
+   * @param vdfs             VDFS to read the file from.
+   * @param importerVersion  Version of the importer creating the resource.
+   * @param outStamp         Filled with the stamp on success.
+   *
+   * @return False, if the file does not exist inside the VDFS.
+   */
+  bool MakeCacheSourceStamp(const bs::String& originalFile, const VDFS::FileIndex& vdfs,
+                            bs::UINT32 importerVersion, CacheSourceStamp& outStamp);
+
 }  // namespace BsZenLib
@@ -0,0 +1,82 @@
+/** \file
+ * Reuse the temporary buffers of imports running on the same thread
+ */
+
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <BsCorePrerequisites.h>
+
+namespace BsZenLib
+{
+  /**
+   * Largest buffer in bytes to keep around once it is given back. Larger ones are freed, so a
+   * single huge asset does not pin its memory on a worker thread for the rest of the run.
+   */
+  constexpr size_t MAX_RETAINED_SCRATCH_BYTES = 64 * 1024 * 1024;
+
+  /**
+   * Temporary buffer borrowed from a pool of the current thread.
+   *
+   * Importers need large temporary buffers for every asset, ie. the file read from the VDFS or
+   * converted vertices. Allocating and freeing them over and over again from many import tasks
+   * at once makes the threads fight over the allocator and touch fresh pages all the time.
+   *
+   * A ScratchBuffer takes an empty buffer out of the pool instead, which still has the capacity
+   * of its last use. Once the ScratchBuffer goes out of scope, ie. when the asset is done, the
+   * buffer is cleared and put back. As every thread has its own pool, this needs no locking.
+   *
+   *     ScratchBuffer<Vector<SkeletalVertex>> vertices;
+   *     vertices->reserve(packedMesh.vertices.size());
+   *
+   * @tparam Container  Container with a std::vector-like interface.
+   *
+   * @note Don't let it outlive the scope it was created in, ie. by handing it to another thread.
+   */
+  template <typename Container>
+  class ScratchBuffer
+  {
+  public:
+    ScratchBuffer()
+    {
+      std::vector<Container>& pool = threadPool();
+
+      if (!pool.empty())
+      {
+        mBuffer = std::move(pool.back());
+        pool.pop_back();
+      }
+    }
+
+    ~ScratchBuffer()
+    {
+      mBuffer.clear();
+
+      size_t retainedBytes = mBuffer.capacity() * sizeof(typename Container::value_type);
+
+      if (retainedBytes > MAX_RETAINED_SCRATCH_BYTES) return;
+
+      threadPool().push_back(std::move(mBuffer));
+    }
+
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    Container& operator*() { return mBuffer; }
+    Container* operator->() { return &mBuffer; }
+
+  private:
+    /**
+     * Buffers given back on this thread. Holds as many as were borrowed at once at most.
+     */
+    static std::vector<Container>& threadPool()
+    {
+      static thread_local std::vector<Container> pool;
+      return pool;
+    }
+
+    Container mBuffer;
+  };
+
+}  // namespace BsZenLib
@@ -0,0 +1,67 @@
+/** \file
+ * Block-compress uncompressed textures on the CPU
+ */
+
+#pragma once
+#include <BsCorePrerequisites.h>
+#include <Image/BsPixelData.h>
+#include <Image/BsPixelUtil.h>
+
+namespace BsZenLib
+{
+  /**
+   * Block compression applied to textures which the game stores uncompressed.
+   */
+  enum class TextureCompression
+  {
+    /** Keep them as RGBA8 */
+    None,
+
+    /** BC1 for opaque textures, BC3 for those with alpha. 4 to 8 times smaller than RGBA8. */
+    BC1OrBC3,
+
+    /**
+     * BC7, 4 times smaller than RGBA8 with better quality than BC1/BC3, but slow to encode.
+     * Falls back to BC1OrBC3 if the encoder of bs::f does not support BC7.
+     */
+    BC7,
+  };
+
+  struct TextureCompressionOptions
+  {
+    TextureCompression compression = TextureCompression::None;
+
+    /** Trades encoding speed for quality. */
+    bs::CompressionQuality quality = bs::CompressionQuality::Normal;
+  };
+
+  /**
+   * @return Whether any pixel of the given RGBA8 image is not fully opaque.
+   */
+  bool HasTransparentPixelsRGBA8(const bs::PixelData& image);
+
+  /**
+   * Picks the block compressed format to store the given RGBA8 image in.
+   *
+   * @return PF_UNKNOWN if the image should not be compressed.
+   */
+  bs::PixelFormat ChooseCompressedFormat(const bs::PixelData& image,
+                                         TextureCompression compression);
+
+  /**
+   * Block-compresses the given RGBA8 image using the encoder of bs::f.
+   *
+   * Larger images are split into bands of block rows, which are encoded in parallel on the
+   * bs::f task scheduler. Every block only depends on its own pixels, so the result is the same
+   * as encoding the whole image at once.
+   *
+   * @param image   Tightly packed PF_RGBA8 image.
+   * @param format  One of the block compressed formats, ie. PF_BC1.
+   * @param isSRGB  Whether the image holds sRGB colors, which the encoder weighs differently.
+   *
+   * @return The compressed image.
+   */
+  bs::SPtr<bs::PixelData> CompressRGBA8(const bs::PixelData& image, bs::PixelFormat format,
+                                        bs::CompressionQuality quality, bool isSRGB);
+
+}  // namespace BsZenLib
@@ -0,0 +1,82 @@
+/** \file
+ * Look up size and format of cached textures without loading them
+ */
+
+#pragma once
+#include <BsCorePrerequisites.h>
+#include <Image/BsPixelData.h>
+
+namespace BsZenLib
+{
+  /**
+   * What is known about a cached texture without loading it.
+   */
+  struct CachedTextureInfo
+  {
+    /** Name of the texture in the original games files (ie. "STONE.TGA") */
+    bs::String name;
+
+    bs::UINT32 width = 0;
+    bs::UINT32 height = 0;
+
+    /** Number of mip-map levels, including the base level. */
+    bs::UINT32 numMips = 0;
+
+    /** Format the texture has been cached in. */
+    bs::PixelFormat format = bs::PF_UNKNOWN;
+
+    /** Bytes all mip-map levels of the full texture take up in memory. */
+    bs::UINT64 memorySize = 0;
+
+    /** Hash of the compiled texture it was built from, see CacheSourceStamp::sourceHash. */
+    bs::UINT64 sourceHash = 0;
+
+    /** Version of the importer which created it, see CacheSourceStamp::importerVersion. */
+    bs::UINT32 importerVersion = 0;
+  };
+
+  /**
+   * Looks up a texture inside the texture index.
+   *
+   * ImportAndCacheTexture() puts every texture it caches into the index, which is stored inside
+   * the cache directory as `gothic-cache.textures`. The index is read once on first use and
+   * kept in memory afterwards, so this is cheap enough to be called for every texture of a
+   * world, ie. to plan how much memory streaming them in will take.
+   *
+   * Textures cached before the index existed are not listed until they are cached again.
+   * Textures missing from the resource manifest are dropped when the index is read, otherwise
+   * the entry does not say whether the cached file still exists, see HasCachedTexture().
+   *
+   * @param originalFileName  Name of the texture in the original games files (ie. "STONE.TGA")
+   * @param outInfo           Receives what is known about the texture.
+   *
+   * @return False, if the texture is not inside the index.
+   *
+   * @note This is threadsafe.
+   */
+  bool FindCachedTextureInfo(const bs::String& originalFileName, CachedTextureInfo& outInfo);
+
+  /**
+   * @return Every texture inside the texture index, in no particular order.
+   *
+   * @note This is threadsafe.
+   */
+  bs::Vector<CachedTextureInfo> GetCachedTextureInfos();
+
+  /**
+   * Puts a texture into the texture index, replacing what was known about it before. The entry
+   * is written to disk right away.
+   *
+   * @note This is threadsafe and can be called from multiple import tasks at once.
+   */
+  void AddToTextureIndex(const CachedTextureInfo& info);
+
+  /**
+   * Removes a texture from the texture index, ie. because its cached file is gone. The index
+   * file is rewritten right away. Does nothing if the texture is not inside the index.
+   *
+   * @note This is threadsafe.
+   */
+  void RemoveFromTextureIndex(const bs::String& originalFileName);
+
+}  // namespace BsZenLib
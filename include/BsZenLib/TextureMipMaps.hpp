@@ -0,0 +1,38 @@
+/** \file
+ * Generate the mip-map chain of uncompressed textures
+ */
+
+#pragma once
+#include <BsCorePrerequisites.h>
+#include <Image/BsPixelData.h>
+
+namespace BsZenLib
+{
+  /**
+   * Filter used to downsample one mip-map level into the next.
+   */
+  enum class TextureMipFilter
+  {
+    /** Kaiser-windowed sinc, sharp but wide. Same as bs::MipMapFilter::Kaiser. */
+    Kaiser,
+
+    /** Average of the pixels covered by the smaller pixel. Much cheaper, but blurrier. */
+    Box,
+  };
+
+  /**
+   * Generates all mip-map levels below the given RGBA8 image, down to 1x1.
+   *
+   * Every level is downsampled from the previous one by a separable filter. Larger levels are
+   * split into tiles of rows which run on the bs::f task scheduler, while the calling thread
+   * works on a tile as well. This may be called from within a task.
+   *
+   * @param base    Base level, must be tightly packed PF_RGBA8.
+   * @param filter  Filter to downsample with.
+   *
+   * @return Levels 1 to n, not including the base level. Empty if the base level is 1x1.
+   */
+  bs::Vector<bs::SPtr<bs::PixelData>> GenerateMipMapsRGBA8(const bs::PixelData& base,
+                                                           TextureMipFilter filter);
+
+}  // namespace BsZenLib
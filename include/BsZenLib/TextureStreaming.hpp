@@ -0,0 +1,101 @@
+/** \file
+ * Start out with small textures and stream in their full resolution later
+ */
+
+#pragma once
+#include <functional>
+#include <BsCorePrerequisites.h>
+#include <Image/BsTexture.h>
+#include <Material/BsMaterial.h>
+
+namespace BsZenLib
+{
+  /**
+   * Largest width or height of the mip-map levels stored in the tail of a cached texture.
+   *
+   * When caching a texture, its mip-map levels of up to this size are saved a second time as a
+   * separate, small texture: the *tail*. Textures which are that small already don't get one.
+   */
+  constexpr bs::UINT32 TEXTURE_TAIL_SIZE = 64;
+
+  /**
+   * Enables or disables texture streaming for materials imported from now on. Disabled by
+   * default.
+   *
+   * With streaming enabled, cached materials reference the tail of their texture instead of
+   * the full one. Loading them, ie. with a world, then only loads the small tails. The full
+   * textures have to be requested using RequestMaterialDetail().
+   *
+   * @note This only affects materials cached while it is enabled. Materials are cached along
+   *       with their meshes, so switching this makes all cached static meshes, model scripts and
+   *       worlds outdated, see GetStaticMeshImporterVersion().
+   */
+  void SetTextureStreamingEnabled(bool enabled);
+
+  /**
+   * @return Whether materials imported from now on reference texture tails.
+   */
+  bool IsTextureStreamingEnabled();
+
+  /**
+   * @return Whether the tail of the given texture has been cached.
+   */
+  bool HasCachedTextureTail(const bs::String& originalFileName);
+
+  /**
+   * Loads the tail of a cached texture. Falls back to the full texture if it doesn't have a
+   * tail, because it is small enough already.
+   *
+   * @param originalFileName  Name of the texture in the original games files (ie. "STONE.TGA")
+   *
+   * @return Handle to the tail (Empty handle if neither tail nor texture have been cached)
+   */
+  bs::HTexture LoadCachedTextureTail(const bs::String& originalFileName);
+
+  /**
+   * Requests the full resolution of a cached texture to be loaded in the background. Loads are
+   * started and finished by UpdateTextureStreaming().
+   *
+   * Requesting a texture which has been requested already only raises the priority of the
+   * request, if higher, and adds the callback.
+   *
+   * @param originalFileName  Name of the texture in the original games files (ie. "STONE.TGA")
+   * @param priority          Requests with higher priority are loaded first. Pass the negated
+   *                          distance to the viewer to load nearby textures first.
+   * @param onLoaded          Called from UpdateTextureStreaming() once the texture is loaded.
+   *
+   * @note This is threadsafe.
+   */
+  void RequestTextureDetail(const bs::String& originalFileName, float priority,
+                            std::function<void(const bs::HTexture&)> onLoaded);
+
+  /**
+   * Requests the full resolution of the texture the given material currently uses, and puts it
+   * into the material once it is loaded. Does nothing if the material has no texture or already
+   * uses the full one.
+   *
+   * See RequestTextureDetail().
+   */
+  void RequestMaterialDetail(const bs::HMaterial& material, float priority);
+
+  /**
+   * Starts loading the requests with the highest priority, so that no more than the given number
+   * of loads are running at once, and calls the callbacks of all finished ones. Failed loads
+   * are dropped without calling their callbacks.
+   *
+   * Call this once per frame from the main thread. Callbacks are run from within this call.
+   */
+  void UpdateTextureStreaming(bs::UINT32 maxLoadsInFlight = 4);
+
+  /**
+   * @return Number of requests which have not finished loading yet.
+   */
+  bs::UINT32 GetNumPendingTextureDetailRequests();
+
+  /**
+   * Forgets all requests. Loads which are already running will still finish, but their
+   * callbacks won't be called.
+   */
+  void CancelTextureDetailRequests();
+
+}  // namespace BsZenLib
@@ -0,0 +1,112 @@
+/** \file
+ * Split world meshes into chunks which can be culled and streamed on their own
+ */
+
+#pragma once
+#include "ResourceManifest.hpp"
+#include <BsCorePrerequisites.h>
+#include <Math/BsAABox.h>
+#include <Material/BsMaterial.h>
+#include <Scene/BsSceneObject.h>
+
+namespace ZenLoad
+{
+  struct PackedMesh;
+}
+
+namespace BsZenLib
+{
+  /**
+   * A piece of a world mesh, as listed inside the chunk index of a world.
+   */
+  struct WorldChunk
+  {
+    /** Name the chunk is cached under, see LoadCachedStaticMesh(). */
+    bs::String meshName;
+
+    /** Bounds of all vertices of the chunk, in world space. */
+    bs::AABox bounds;
+  };
+
+  /**
+   * Sets the edge length of the chunks in meters, which world meshes imported from now on are
+   * split into. 0 disables splitting, which is the default.
+   *
+   * Worlds are split along a grid on the ground plane, triangles go into the cell holding
+   * their center. Every chunk has its own renderable, so the renderer can cull it, and its own
+   * collider. Their meshes can be loaded and unloaded by distance, see UpdateWorldChunks().
+   *
+   * The world mesh is still cached as a whole, as its materials are shared with the chunks.
+   * The chunks and their index only add to it.
+   *
+   * @note This is threadsafe, but imports already running keep the size they started with.
+   */
+  void SetWorldChunkSize(float meters);
+
+  /**
+   * @return Edge length of the chunks world meshes are split into, 0 if they are not split.
+   */
+  float GetWorldChunkSize();
+
+  /**
+   * Splits the given world mesh into chunks of the current chunk size, caches every chunk as
+   * a static mesh and writes the chunk index of the world.
+   *
+   * @param worldName  Name of the world (ie. "NEWWORLD.ZEN")
+   * @param worldMesh  Packed mesh of the world.
+   * @param materials  Materials of the world mesh, one per submesh. Chunks reference them
+   *                   rather than having their own.
+   * @param stamp      Source stamp of the world, see MakeCacheSourceStamp().
+   *
+   * @return False, if splitting is disabled or anything could not be cached.
+   */
+  bool ImportAndCacheWorldChunks(const bs::String& worldName,
+                                 const ZenLoad::PackedMesh& worldMesh,
+                                 const bs::Vector<bs::HMaterial>& materials,
+                                 const CacheSourceStamp& stamp);
+
+  /**
+   * @param worldName  Name of the world (ie. "NEWWORLD.ZEN")
+   * @param stamp      Source stamp of the world, see MakeCacheSourceStamp().
+   *
+   * @return Whether the given world has been split into chunks of the current chunk size, from
+   *         the same source and by the same importer as given by the stamp.
+   */
+  bool HasCachedWorldChunks(const bs::String& worldName, const CacheSourceStamp& stamp);
+
+  /**
+   * @return The chunks the given world has been split into (Empty if it wasn't)
+   */
+  bs::Vector<WorldChunk> LoadWorldChunkIndex(const bs::String& worldName);
+
+  /**
+   * Creates a scene object named like the world mesh (ie. "NEWWORLD.ZEN.worldmesh") with one
+   * child per chunk, named after its mesh. The chunks start out inactive and without their
+   * meshes, call UpdateWorldChunks() to load the ones around the viewer.
+   *
+   * ImportZEN() uses this instead of a single world mesh when chunks have been cached.
+   */
+  bs::HSceneObject CreateWorldChunkObjects(const bs::String& worldName,
+                                           const bs::Vector<WorldChunk>& chunks);
+
+  /**
+   * Loads the meshes of the chunks within the given distance of the viewer, nearest first, and
+   * unloads the others. Unloaded chunks are deactivated and their meshes released, so bs::f
+   * frees them once nothing else references them.
+   *
+   * With texture streaming enabled, loading a chunk also requests the full textures of its
+   * materials, see RequestMaterialDetail().
+   *
+   * Call this from the main thread whenever the viewer has moved far enough.
+   *
+   * @param chunksSO          Scene object created by CreateWorldChunkObjects().
+   * @param chunks            Chunk index of the world, see LoadWorldChunkIndex().
+   * @param viewPosition      Position of the viewer.
+   * @param loadDistance      Chunks whose bounds are farther away than this are unloaded.
+   * @param maxLoadsPerUpdate Chunks to load at most, as loading blocks until done.
+   */
+  void UpdateWorldChunks(const bs::HSceneObject& chunksSO, const bs::Vector<WorldChunk>& chunks,
+                         const bs::Vector3& viewPosition, float loadDistance,
+                         bs::UINT32 maxLoadsPerUpdate = 2);
+
+}  // namespace BsZenLib
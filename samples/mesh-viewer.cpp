@@ -7,6 +7,7 @@
 #include <BsZenLib/ImportSkeletalMesh.hpp>
 #include <BsZenLib/ImportStaticMesh.hpp>
 #include <BsZenLib/ImportZEN.hpp>
+#include <BsZenLib/ResourceManifest.hpp>
 #include <Components/BsCCamera.h>
 #include <Components/BsCLight.h>
 #include <Components/BsCRenderable.h>
@@ -242,6 +243,7 @@ int main(int argc, char** argv)
   SPtr<ResourceManifest> manifest = gResources().getResourceManifest("Default");
   ResourceManifest::save(manifest, BsZenLib::GothicPathToCachedManifest("resources"), BsZenLib::GetCacheDirectory());
 
+  BsZenLib::FlushResourceManifestJournal();
   Application::shutDown();
   return 0;
 }
@@ -9,6 +9,7 @@
 #include <BsZenLib/ImportStaticMesh.hpp>
 #include <BsZenLib/ImportSkeletalMesh.hpp>
 #include <BsZenLib/ImportZEN.hpp>
+#include <BsZenLib/ResourceManifest.hpp>
 #include <Components/BsCAnimation.h>
 #include <Components/BsCCamera.h>
 #include <Components/BsCLight.h>
@@ -221,6 +222,7 @@ int main(int argc, char** argv)
   manifest = gResources().getResourceManifest("Default");
   ResourceManifest::save(manifest, BsZenLib::GothicPathToCachedManifest("resources"), BsZenLib::GetCacheDirectory());
 
+  BsZenLib::FlushResourceManifestJournal();
   Application::shutDown();
   return 0;
 }
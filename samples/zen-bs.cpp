@@ -3,6 +3,7 @@
 #include "BsFPSCamera.h"
 #include <assert.h>
 #include <BsZenLib/ImportZEN.hpp>
+#include <BsZenLib/ResourceManifest.hpp>
 #include <Components/BsCCamera.h>
 #include <Components/BsCLight.h>
 #include <Components/BsCRenderable.h>
@@ -172,6 +173,7 @@ int main(int argc, char** argv)
   SPtr<ResourceManifest> manifest = gResources().getResourceManifest("Default");
   ResourceManifest::save(manifest, BsZenLib::GothicPathToCachedManifest("resources"), BsZenLib::GetCacheDirectory());
 
+  BsZenLib::FlushResourceManifestJournal();
   Application::shutDown();
   return 0;
 }
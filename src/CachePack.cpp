@@ -0,0 +1,581 @@
+/**
+ * Cache Pack
+ * ==========
+ *
+ * The pack is a copy of every cached `.asset`-file, put one after another into a single file.
+ * Layout:
+ *
+ *     PackHeader
+ *     <serialized resources, each starting at a 16 byte boundary>
+ *     PackIndexEntry[numEntries], sorted by path hash and path
+ *     <string table holding the paths and UUIDs referenced by the index>
+ *
+ * Paths are stored relative to the cache directory, with forward slashes. Looking up a path is
+ * a binary search over the index, which can be done right on the mapped memory.
+ *
+ * The resources are stored exactly like bs::f saves them: first the SavedResourceData listing
+ * the dependencies, then the resource itself, each prefixed with its size. Loading one
+ * deserializes it straight from the mapping and registers it with bs::f under the UUID it has
+ * in the resource manifest, so other resources referencing it find it. Dependencies are loaded
+ * first for the same reason.
+ *
+ * The mounted pack is shared with every load running, which only takes the lock to get hold of it
+ * and to register what it loaded. Caching a resource again registers it under a new UUID, so an
+ * entry whose UUID differs from the one inside the resource manifest is outdated and skipped.
+ * This only looks at the manifest in memory, packed loads don't touch the loose files at all.
+ */
+
+#include "CachePack.hpp"
+#include "ImportPath.hpp"
+#include "ResourceManifest.hpp"
+#include <algorithm>
+#include <cstring>
+#include <FileSystem/BsDataStream.h>
+#include <FileSystem/BsFileSystem.h>
+#include <Resources/BsResource.h>
+#include <Resources/BsResources.h>
+#include <Resources/BsSavedResourceData.h>
+#include <Serialization/BsBinarySerializer.h>
+#include <Threading/BsThreading.h>
+
+#if BS_PLATFORM == BS_PLATFORM_WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace bs;
+
+constexpr auto GOTHIC_CACHE_PACK_FILE = "gothic-cache.pack";
+
+/**
+ * Bump this whenever the layout of the pack changes.
+ */
+constexpr UINT32 PACK_VERSION = 1;
+constexpr char PACK_MAGIC[8] = {'B', 'S', 'Z', 'P', 'A', 'C', 'K', '\0'};
+constexpr UINT64 PACK_DATA_ALIGNMENT = 16;
+
+namespace
+{
+  struct PackHeader
+  {
+    char magic[8];
+    UINT32 version;
+    UINT32 numEntries;
+    UINT64 indexOffset;
+    UINT64 stringsOffset;
+  };
+
+  struct PackIndexEntry
+  {
+    UINT64 pathHash;
+    UINT64 dataOffset;
+    UINT64 dataSize;
+    UINT32 pathOffset;
+    UINT32 pathLength;
+    UINT32 uuidOffset;
+    UINT32 uuidLength;
+  };
+
+  /**
+   * Read-only mapping of a whole file into memory.
+   */
+  class MappedFile
+  {
+  public:
+    ~MappedFile() { unmap(); }
+
+    bool map(const Path& path)
+    {
+      unmap();
+
+#if BS_PLATFORM == BS_PLATFORM_WIN32
+      HANDLE file = CreateFileA(path.toPlatformString().c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+      if (file == INVALID_HANDLE_VALUE) return false;
+
+      LARGE_INTEGER size;
+      GetFileSizeEx(file, &size);
+
+      HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      CloseHandle(file);
+
+      if (!mapping) return false;
+
+      mData = (const UINT8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+
+      if (!mData) return false;
+
+      mSize = (size_t)size.QuadPart;
+#else
+      int file = open(path.toPlatformString().c_str(), O_RDONLY);
+
+      if (file < 0) return false;
+
+      struct stat info;
+
+      if (fstat(file, &info) != 0 || info.st_size == 0)
+      {
+        close(file);
+        return false;
+      }
+
+      void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+      close(file);
+
+      if (data == MAP_FAILED) return false;
+
+      mData = (const UINT8*)data;
+      mSize = (size_t)info.st_size;
+#endif
+
+      return true;
+    }
+
+    void unmap()
+    {
+      if (!mData) return;
+
+#if BS_PLATFORM == BS_PLATFORM_WIN32
+      UnmapViewOfFile(mData);
+#else
+      munmap((void*)mData, mSize);
+#endif
+
+      mData = nullptr;
+      mSize = 0;
+    }
+
+    const UINT8* data() const { return mData; }
+    size_t size() const { return mSize; }
+
+  private:
+    const UINT8* mData = nullptr;
+    size_t mSize = 0;
+  };
+
+  /**
+   * A cached file to be written into the pack.
+   */
+  struct PackSource
+  {
+    Path file;
+    String key;
+    String uuid;
+    UINT64 hash;
+    UINT64 size;
+  };
+
+  /**
+   * A mounted pack. Loads keep hold of it while reading from the mapping, so unmounting does
+   * not pull the memory away from under them. Nothing inside changes once it is mounted.
+   */
+  struct MountedPack
+  {
+    MappedFile file;
+    const PackIndexEntry* index = nullptr;
+    UINT32 numEntries = 0;
+  };
+}  // namespace
+
+static Mutex s_PackMutex;
+static SPtr<MountedPack> s_Pack;
+
+static Path packFilePath();
+static String packKey(const Path& cachePath);
+static UINT64 hashKey(const String& key);
+static SPtr<MountedPack> mountedPack();
+static const PackIndexEntry* findEntry(const MountedPack& pack, const String& key);
+static String readString(const MountedPack& pack, UINT32 offset, UINT32 length);
+static bool isOutdated(const Path& cachePath, const UUID& packedUUID);
+static HResource loadPacked(const MountedPack& pack, const Path& cachePath);
+static SPtr<IReflectable> decodeObject(const SPtr<DataStream>& stream);
+static bool validatePack(MountedPack& pack);
+
+// - Implementation --------------------------------------------------------------------------------
+
+bool BsZenLib::BuildCachePack()
+{
+  UnmountCachePack();
+
+  Vector<PackSource> sources;
+
+  auto onFile = [&](const Path& file) {
+    if (file.getExtension() != ".asset") return true;
+
+    UUID uuid;
+    if (!gResources().getUUIDFromFilePath(file, uuid))
+    {
+      // Not part of the saved manifest, so nothing could reference it
+      return true;
+    }
+
+    PackSource source;
+    source.file = file;
+    source.key = packKey(file);
+    source.uuid = uuid.toString();
+    source.hash = hashKey(source.key);
+    source.size = FileSystem::getFileSize(file);
+
+    sources.push_back(source);
+
+    return true;
+  };
+
+  const bool recursive = true;
+  FileSystem::iterate(GetCacheDirectory(), onFile, nullptr, recursive);
+
+  std::sort(sources.begin(), sources.end(), [](const PackSource& a, const PackSource& b) {
+    if (a.hash != b.hash) return a.hash < b.hash;
+    return a.key < b.key;
+  });
+
+  // Lay out the pack before writing, so everything can be written in one go
+  Vector<PackIndexEntry> index(sources.size());
+  String strings;
+  UINT64 offset = sizeof(PackHeader);
+
+  for (size_t i = 0; i < sources.size(); i++)
+  {
+    offset = (offset + PACK_DATA_ALIGNMENT - 1) & ~(PACK_DATA_ALIGNMENT - 1);
+
+    index[i].pathHash = sources[i].hash;
+    index[i].dataOffset = offset;
+    index[i].dataSize = sources[i].size;
+    index[i].pathOffset = (UINT32)strings.size();
+    index[i].pathLength = (UINT32)sources[i].key.size();
+    strings += sources[i].key;
+    index[i].uuidOffset = (UINT32)strings.size();
+    index[i].uuidLength = (UINT32)sources[i].uuid.size();
+    strings += sources[i].uuid;
+
+    offset += sources[i].size;
+  }
+
+  PackHeader header = {};
+  memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+  header.version = PACK_VERSION;
+  header.numEntries = (UINT32)index.size();
+  header.indexOffset = (offset + PACK_DATA_ALIGNMENT - 1) & ~(PACK_DATA_ALIGNMENT - 1);
+  header.stringsOffset = header.indexOffset + index.size() * sizeof(PackIndexEntry);
+
+  // Write into a temporary file first, so a failed build does not destroy a working pack
+  Path temporary = packFilePath();
+  temporary.setFilename(String(GOTHIC_CACHE_PACK_FILE) + ".tmp");
+
+  SPtr<DataStream> out = FileSystem::createAndOpenFile(temporary);
+
+  if (!out)
+  {
+    BS_LOG(Error, Uncategorized, "Could not write cache pack to {0}", temporary);
+    return false;
+  }
+
+  const UINT8 padding[PACK_DATA_ALIGNMENT] = {};
+  UINT64 written = 0;
+
+  auto writePaddingTo = [&](UINT64 target) {
+    out->write(padding, (size_t)(target - written));
+    written = target;
+  };
+
+  out->write(&header, sizeof(header));
+  written += sizeof(header);
+
+  Vector<UINT8> data;
+
+  for (size_t i = 0; i < sources.size(); i++)
+  {
+    writePaddingTo(index[i].dataOffset);
+
+    SPtr<DataStream> in = FileSystem::openFile(sources[i].file);
+
+    data.resize((size_t)sources[i].size);
+
+    if (!in || in->read(data.data(), data.size()) != data.size())
+    {
+      BS_LOG(Error, Uncategorized, "Could not read {0} into the cache pack", sources[i].file);
+
+      out->close();
+      FileSystem::remove(temporary);
+      return false;
+    }
+
+    out->write(data.data(), data.size());
+    written += data.size();
+  }
+
+  writePaddingTo(header.indexOffset);
+
+  out->write(index.data(), index.size() * sizeof(PackIndexEntry));
+  out->write(strings.data(), strings.size());
+  out->close();
+
+  const bool overwrite = true;
+  FileSystem::move(temporary, packFilePath(), overwrite);
+
+  BS_LOG(Info, Uncategorized, "Packed {0} cached resource(s) into {1}", sources.size(),
+         packFilePath());
+
+  return true;
+}
+
+bool BsZenLib::MountCachePack()
+{
+  UnmountCachePack();
+
+  if (!FileSystem::isFile(packFilePath())) return false;
+
+  SPtr<MountedPack> pack = bs_shared_ptr_new<MountedPack>();
+
+  if (!pack->file.map(packFilePath()))
+  {
+    BS_LOG(Error, Uncategorized, "Could not map cache pack {0}", packFilePath());
+    return false;
+  }
+
+  if (!validatePack(*pack))
+  {
+    BS_LOG(Error, Uncategorized, "Cache pack {0} is broken or outdated, ignoring it",
+           packFilePath());
+
+    return false;
+  }
+
+  Lock lock(s_PackMutex);
+  s_Pack = pack;
+
+  return true;
+}
+
+void BsZenLib::UnmountCachePack()
+{
+  Lock lock(s_PackMutex);
+
+  // Loads still running keep their own reference, the mapping goes away after the last one
+  s_Pack = nullptr;
+}
+
+bool BsZenLib::IsCachePackMounted()
+{
+  return mountedPack() != nullptr;
+}
+
+bool BsZenLib::HasPackedResource(const bs::Path& cachePath)
+{
+  SPtr<MountedPack> pack = mountedPack();
+
+  if (!pack) return false;
+
+  return findEntry(*pack, packKey(cachePath)) != nullptr;
+}
+
+bs::HResource BsZenLib::LoadPackedResource(const bs::Path& cachePath)
+{
+  SPtr<MountedPack> pack = mountedPack();
+
+  if (!pack) return {};
+
+  return loadPacked(*pack, cachePath);
+}
+
+static Path packFilePath()
+{
+  return BsZenLib::GetCacheDirectory() + Path(GOTHIC_CACHE_PACK_FILE);
+}
+
+static String packKey(const Path& cachePath)
+{
+  String key = cachePath.getRelative(BsZenLib::GetCacheDirectory()).toString();
+
+  return StringUtil::replaceAll(key, "\\", "/");
+}
+
+/**
+ * FNV-1a, same as used for the paths inside the resource manifest.
+ */
+static UINT64 hashKey(const String& key)
+{
+  UINT64 hash = 0xcbf29ce484222325ull;
+
+  for (char c : key)
+  {
+    hash ^= (UINT8)c;
+    hash *= 0x100000001b3ull;
+  }
+
+  return hash;
+}
+
+/**
+ * The lock is only held while grabbing the pack, everything after works on the pack alone.
+ */
+static SPtr<MountedPack> mountedPack()
+{
+  Lock lock(s_PackMutex);
+
+  return s_Pack;
+}
+
+static const PackIndexEntry* findEntry(const MountedPack& pack, const String& key)
+{
+  UINT64 hash = hashKey(key);
+
+  const PackIndexEntry* end = pack.index + pack.numEntries;
+  const PackIndexEntry* it = std::lower_bound(
+      pack.index, end, hash, [](const PackIndexEntry& e, UINT64 h) { return e.pathHash < h; });
+
+  for (; it != end && it->pathHash == hash; it++)
+  {
+    if (readString(pack, it->pathOffset, it->pathLength) == key) return it;
+  }
+
+  return nullptr;
+}
+
+static String readString(const MountedPack& pack, UINT32 offset, UINT32 length)
+{
+  const PackHeader* header = (const PackHeader*)pack.file.data();
+
+  return String((const char*)pack.file.data() + header->stringsOffset + offset, length);
+}
+
+/**
+ * Resources cached again after the pack was built are registered under a new UUID and only up
+ * to date as loose files.
+ */
+static bool isOutdated(const Path& cachePath, const UUID& packedUUID)
+{
+  UUID registered;
+
+  if (!BsZenLib::FindCachedResourceUUID(cachePath, registered)) return false;
+
+  return registered != packedUUID;
+}
+
+static HResource loadPacked(const MountedPack& pack, const Path& cachePath)
+{
+  String key = packKey(cachePath);
+  const PackIndexEntry* entry = findEntry(pack, key);
+
+  if (!entry) return {};
+
+  UUID uuid(readString(pack, entry->uuidOffset, entry->uuidLength));
+
+  if (isOutdated(cachePath, uuid)) return {};
+
+  HResource existing = gResources()._getResourceHandle(uuid);
+
+  if (existing && existing.isLoaded(false)) return existing;
+
+  // Deserializes straight from the mapping, nothing is copied
+  UINT8* data = const_cast<UINT8*>(pack.file.data() + entry->dataOffset);
+  const bool freeOnClose = false;
+
+  SPtr<DataStream> stream =
+      bs_shared_ptr_new<MemoryDataStream>(data, (size_t)entry->dataSize, freeOnClose);
+
+  SPtr<SavedResourceData> savedData =
+      std::static_pointer_cast<SavedResourceData>(decodeObject(stream));
+
+  if (!savedData) return {};
+
+  // Handles to dependencies are resolved by UUID while deserializing, so they have to be
+  // loaded before the resource itself
+  for (const UUID& dependency : savedData->getDependencies())
+  {
+    Path dependencyPath;
+
+    if (!gResources().getFilePathFromUUID(dependency, dependencyPath)) continue;
+
+    if (!loadPacked(pack, dependencyPath))
+    {
+      gResources().load(dependencyPath);
+    }
+  }
+
+  SPtr<Resource> resource = std::static_pointer_cast<Resource>(decodeObject(stream));
+
+  if (!resource)
+  {
+    BS_LOG(Warning, Uncategorized, "Could not load {0} from the cache pack", key);
+    return {};
+  }
+
+  // Two threads may have loaded the same resource at once, only the first one gets registered
+  Lock lock(s_PackMutex);
+
+  existing = gResources()._getResourceHandle(uuid);
+
+  if (existing && existing.isLoaded(false)) return existing;
+
+  return gResources()._createResourceHandle(resource, uuid);
+}
+
+/**
+ * Decodes the next object from a stream written by a bs::f FileEncoder.
+ */
+static SPtr<IReflectable> decodeObject(const SPtr<DataStream>& stream)
+{
+  UINT32 objectSize = 0;
+
+  if (stream->read(&objectSize, sizeof(objectSize)) != sizeof(objectSize)) return nullptr;
+
+  BinarySerializer serializer;
+
+  return serializer.decode(stream, objectSize);
+}
+
+/**
+ * Makes sure header, index and string table lie within the mapped file, and so does everything
+ * the index points to. Lookups and loads rely on this and don't check again.
+ */
+static bool validatePack(MountedPack& pack)
+{
+  const UINT64 packSize = pack.file.size();
+
+  if (packSize < sizeof(PackHeader)) return false;
+
+  const PackHeader* header = (const PackHeader*)pack.file.data();
+
+  if (memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0) return false;
+  if (header->version != PACK_VERSION) return false;
+
+  UINT64 indexSize = (UINT64)header->numEntries * sizeof(PackIndexEntry);
+
+  // Compared by subtracting, so corrupt offsets can't overflow
+  if (header->indexOffset < sizeof(PackHeader)) return false;
+  if (header->indexOffset % PACK_DATA_ALIGNMENT != 0) return false;
+  if (header->stringsOffset > packSize) return false;
+  if (header->indexOffset > header->stringsOffset) return false;
+  if (indexSize > header->stringsOffset - header->indexOffset) return false;
+
+  const PackIndexEntry* index = (const PackIndexEntry*)(pack.file.data() + header->indexOffset);
+  const UINT64 stringsSize = packSize - header->stringsOffset;
+
+  auto fitsInto = [](UINT64 offset, UINT64 size, UINT64 available) {
+    return offset <= available && size <= available - offset;
+  };
+
+  for (UINT32 i = 0; i < header->numEntries; i++)
+  {
+    const PackIndexEntry& entry = index[i];
+
+    if (entry.dataOffset < sizeof(PackHeader)) return false;
+    if (!fitsInto(entry.dataOffset, entry.dataSize, header->indexOffset)) return false;
+    if (!fitsInto(entry.pathOffset, entry.pathLength, stringsSize)) return false;
+    if (!fitsInto(entry.uuidOffset, entry.uuidLength, stringsSize)) return false;
+  }
+
+  pack.index = index;
+  pack.numEntries = header->numEntries;
+
+  return true;
+}
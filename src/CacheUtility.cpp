@@ -1,77 +1,700 @@
+/**
+ * Cache Utility
+ * =============
+ *
+ * Caching a whole VDFS is done by building a graph of import work, where each node only runs
+ * once everything it depends on has been imported. The dependencies follow the references
+ * between the assets:
+ *
+ *     textures -> materials -> static meshes / world meshes
+ *
+ * Meshes and worlds are first scanned for the materials they use, which adds the material and
+ * mesh nodes to the graph. This way, every texture is imported exactly once and materials can
+ * be created as soon as their texture is ready, without waiting for all other textures.
+ *
+ * Model scripts are imported in nodes of their own, which pull in their meshes, materials and
+ * textures as needed. Some of them are known to be broken, so each one is isolated: a failed
+ * import is turned into a failure record (see GetCacheFailures()) and the model is put into
+ * quarantine. Quarantined models are skipped by later runs until either the model script or the
+ * importer changes. The quarantine list is stored in the cache directory
+ * as `gothic-cache.quarantine`, in the same format as the cache stamps.
+ */
+
 #include "CacheUtility.hpp"
+#include "CachePack.hpp"
+#include "ImportMaterial.hpp"
+#include "ImportMetrics.hpp"
+#include "ImportPath.hpp"
 #include "ImportSkeletalMesh.hpp"
 #include "ImportStaticMesh.hpp"
 #include "ImportTexture.hpp"
+#include "LineRecords.hpp"
+#include "ResourceManifest.hpp"
+#include "WorldChunks.hpp"
+#include <Error/BsException.h>
+#include <FileSystem/BsFileSystem.h>
 #include <Threading/BsTaskScheduler.h>
+#include <Threading/BsThreading.h>
 #include <vdfs/fileIndex.h>
+#include <zenload/zCMesh.h>
+#include <zenload/zCProgMeshProto.h>
+#include <zenload/zenParser.h>
 
 using namespace BsZenLib;
 using namespace bs;
 
+constexpr auto QUARANTINE_FILE = "gothic-cache.quarantine";
+
+/**
+ * Failures of the current (or last) call to CacheWholeVDFS().
+ */
+static Mutex s_FailuresMutex;
+static Vector<CacheFailure> s_Failures;
+
+/**
+ * Files found to be missing or outdated by the current (or last) call to CacheWholeVDFS().
+ */
+static Mutex s_OutdatedMutex;
+static Vector<String> s_Outdated;
+
+static void recordFailure(const bs::String& file, const bs::String& reason);
+static bool recordOutdated(const bs::String& file, const CacheOptions& options);
+
+namespace
+{
+  /**
+   * Runs import work as soon as all work it depends on has finished.
+   *
+   * Every piece of work is a node identified by a key (ie. "TEX:STONE.TGA"). Nodes can be added
+   * while the graph is already running, also from within other nodes. Dependencies have to be
+   * added before the nodes depending on them, keys which are unknown at that point are treated
+   * as already finished.
+   *
+   * Nodes which are ready to run are queued up if the maximum number of jobs is reached.
+   */
+  class ImportGraph
+  {
+  public:
+    /**
+     * @param maxJobs  Maximum number of nodes to run at once. 0 leaves it to the task scheduler.
+     */
+    ImportGraph(UINT32 maxJobs)
+        : mMaxJobs(maxJobs)
+    {
+    }
+
+    /**
+     * Adds a node to the graph. If all its dependencies have finished, the work is started
+     * right away. Adding a key which already exists does nothing.
+     */
+    void add(const String& key, const Vector<String>& dependencies, std::function<void()> work)
+    {
+      SPtr<Node> node = bs_shared_ptr_new<Node>();
+      node->key = key;
+      node->work = std::move(work);
+
+      {
+        Lock lock(mMutex);
+
+        if (mNodes.find(key) != mNodes.end()) return;
+
+        mNodes[key] = node;
+        mNumUnfinished++;
+
+        for (const String& dependency : dependencies)
+        {
+          auto it = mNodes.find(dependency);
+
+          if (it == mNodes.end() || it->second->isFinished) continue;
+
+          it->second->dependents.push_back(node);
+          node->numPendingDependencies++;
+        }
+
+        if (node->numPendingDependencies > 0) return;
+      }
+
+      schedule(node);
+    }
+
+    /**
+     * Blocks until all nodes, including the ones added while waiting, have finished.
+     */
+    void wait()
+    {
+      Lock lock(mMutex);
+
+      mAllFinished.wait(lock, [this]() { return mNumUnfinished == 0; });
+    }
+
+  private:
+    struct Node
+    {
+      String key;
+      std::function<void()> work;
+      Vector<SPtr<Node>> dependents;
+      UINT32 numPendingDependencies = 0;
+      bool isFinished = false;
+    };
+
+    /**
+     * Queues up the given node and starts as many queued nodes as allowed.
+     */
+    void schedule(const SPtr<Node>& node)
+    {
+      Vector<SPtr<Node>> toStart;
+
+      {
+        Lock lock(mMutex);
+
+        mReadyQueue.push_back(node);
+        toStart = takeStartableLocked();
+      }
+
+      for (const SPtr<Node>& next : toStart)
+      {
+        submit(next);
+      }
+    }
+
+    /**
+     * Takes as many nodes from the ready-queue as there are free job slots.
+     */
+    Vector<SPtr<Node>> takeStartableLocked()
+    {
+      Vector<SPtr<Node>> toStart;
+
+      while (!mReadyQueue.empty() && (mMaxJobs == 0 || mNumRunning < mMaxJobs))
+      {
+        toStart.push_back(mReadyQueue.front());
+        mReadyQueue.pop_front();
+        mNumRunning++;
+      }
+
+      return toStart;
+    }
+
+    void submit(const SPtr<Node>& node)
+    {
+      SPtr<Task> task = Task::create(node->key, [this, node]() {
+        // Nodes are expected to handle their own errors, this only makes sure a single one
+        // can't take down the worker thread and leave the graph waiting forever
+        try
+        {
+          node->work();
+        }
+        catch (const bs::Exception& e)
+        {
+          recordFailure(node->key, e.getFullDescription());
+        }
+        catch (const std::exception& e)
+        {
+          recordFailure(node->key, e.what());
+        }
+
+        onFinished(node);
+      });
+
+      TaskScheduler::instance().addTask(task);
+    }
+
+    void onFinished(const SPtr<Node>& node)
+    {
+      Vector<SPtr<Node>> toStart;
+
+      {
+        Lock lock(mMutex);
+
+        node->isFinished = true;
+
+        // Free whatever the work has captured, the node itself stays around as a key
+        node->work = nullptr;
+
+        for (const SPtr<Node>& dependent : node->dependents)
+        {
+          if (--dependent->numPendingDependencies == 0) mReadyQueue.push_back(dependent);
+        }
+
+        node->dependents.clear();
+
+        mNumRunning--;
+        toStart = takeStartableLocked();
+
+        // Queued nodes are still counted as unfinished, so this can't hit 0 while there is
+        // work left to start. Once it does, the graph may be gone as soon as the lock is released.
+        mNumUnfinished--;
+
+        if (mNumUnfinished == 0) mAllFinished.notify_all();
+      }
+
+      for (const SPtr<Node>& next : toStart)
+      {
+        submit(next);
+      }
+    }
+
+    Mutex mMutex;
+    Signal mAllFinished;
+    UnorderedMap<String, SPtr<Node>> mNodes;
+    Deque<SPtr<Node>> mReadyQueue;
+    UINT32 mNumUnfinished = 0;
+    UINT32 mNumRunning = 0;
+    UINT32 mMaxJobs;
+  };
+}  // namespace
+
+/**
+ * Stamps of the model scripts which are in quarantine, by file name inside the VDFS.
+ */
+static Mutex s_QuarantineMutex;
+static Map<String, CacheSourceStamp> s_Quarantine;
+
+static void cacheTexture(const bs::String& texture, const VDFS::FileIndex& vdfs,
+                         const CacheOptions& options);
+static void cacheModelScript(const bs::String& mdsFile, const VDFS::FileIndex& vdfs,
+                             const CacheOptions& options);
+static bool isQuarantined(const bs::String& mdsFile, const VDFS::FileIndex& vdfs);
+static void quarantine(const bs::String& mdsFile, const VDFS::FileIndex& vdfs);
+static Path quarantineFilePath();
+static void loadQuarantine();
+static void saveQuarantine();
+static bool hasExtension(const bs::String& file, const bs::String& ext);
+static bs::Vector<bs::String> knownFilesUpperCase(const VDFS::FileIndex& vdfs);
+static bs::String textureKey(const bs::String& texture);
+static void scanStaticMesh(ImportGraph& graph, const bs::String& compiledFile,
+                           const VDFS::FileIndex& vdfs, const CacheOptions& options);
+static void scanWorld(ImportGraph& graph, const bs::String& zen, const VDFS::FileIndex& vdfs,
+                      const CacheOptions& options);
+static void addStaticMeshNodes(ImportGraph& graph, const bs::String& meshName,
+                               SPtr<ZenLoad::PackedMesh> packedMesh,
+                               const CacheSourceStamp& stamp, const VDFS::FileIndex& vdfs);
+static void addWorldChunksNode(ImportGraph& graph, const bs::String& zen,
+                               SPtr<ZenLoad::PackedMesh> packedMesh,
+                               const CacheSourceStamp& stamp);
+
+// - Implementation --------------------------------------------------------------------------------
+
+void BsZenLib::CacheWholeVDFS(const VDFS::FileIndex& vdfs)
+{
+  CacheWholeVDFS(vdfs, CacheOptions());
+}
+
+void BsZenLib::CacheWholeVDFS(const VDFS::FileIndex& vdfs, const CacheOptions& options)
+{
+  {
+    Lock lock(s_FailuresMutex);
+    s_Failures.clear();
+  }
+
+  {
+    Lock lock(s_OutdatedMutex);
+    s_Outdated.clear();
+  }
+
+  loadQuarantine();
+
+  const bool recordMetrics = !options.metricsFile.isEmpty() || !options.traceFile.isEmpty();
+  const bool wasRecordingMetrics = IsImportMetricsEnabled();
+
+  if (recordMetrics)
+  {
+    ResetImportMetrics();
+    SetImportMetricsEnabled(true);
+  }
+
+  ImportGraph graph(options.maxJobs);
+  Vector<String> files = knownFilesUpperCase(vdfs);
+
+  // Textures don't depend on anything and need to be known before the materials using them
+  // are added, so add them first.
+  for (const String& file : files)
+  {
+    if (!options.textures || !hasExtension(file, ".TEX")) continue;
+
+    String uncompiled = StringUtil::replaceAll(file, "-C.TEX", ".TGA");
+
+    graph.add(textureKey(uncompiled), {},
+              [&vdfs, &options, uncompiled]() { cacheTexture(uncompiled, vdfs, options); });
+  }
+
+  for (const String& file : files)
+  {
+    if (options.staticMeshes && hasExtension(file, ".MRM"))
+    {
+      graph.add("SCAN:" + file, {}, [&graph, &vdfs, &options, file]() {
+        scanStaticMesh(graph, file, vdfs, options);
+      });
+    }
+    else if (options.worlds && hasExtension(file, ".ZEN"))
+    {
+      graph.add("SCAN:" + file, {}, [&graph, &vdfs, &options, file]() {
+        scanWorld(graph, file, vdfs, options);
+      });
+    }
+    else if (options.modelScripts && hasExtension(file, ".MDS"))
+    {
+      graph.add("MDS:" + file, {},
+                [&vdfs, &options, file]() { cacheModelScript(file, vdfs, options); });
+    }
+  }
+
+  graph.wait();
+
+  if (!options.dryRun)
+  {
+    // All nodes have finished, so this is the only place writing the manifest
+    SaveResourceManifest();
+    saveQuarantine();
+
+    if (options.buildPack) BuildCachePack();
+  }
+
+  if (recordMetrics)
+  {
+    SetImportMetricsEnabled(wasRecordingMetrics);
+
+    if (!options.metricsFile.isEmpty()) SaveImportMetricsJSON(options.metricsFile);
+    if (!options.traceFile.isEmpty()) SaveImportMetricsChromeTrace(options.traceFile);
+  }
+
+  if (options.dryRun) return;
+
+  Lock lock(s_FailuresMutex);
+
+  if (!s_Failures.empty())
+  {
+    BS_LOG(Warning, Uncategorized, "Caching finished, {0} file(s) failed to import",
+           s_Failures.size());
+  }
+}
+
+bs::Vector<CacheFailure> BsZenLib::GetCacheFailures()
+{
+  Lock lock(s_FailuresMutex);
+
+  return s_Failures;
+}
+
+bs::Vector<bs::String> BsZenLib::GetOutdatedCacheFiles()
+{
+  Lock lock(s_OutdatedMutex);
+
+  return s_Outdated;
+}
+
+/**
+ * Remembers that the given file needs to be imported.
+ *
+ * @return Whether to actually import it, which is not the case on a dry run.
+ */
+static bool recordOutdated(const bs::String& file, const CacheOptions& options)
+{
+  {
+    Lock lock(s_OutdatedMutex);
+    s_Outdated.push_back(file);
+  }
+
+  if (options.dryRun)
+  {
+    BS_LOG(Info, Uncategorized, "Would cache: " + file);
+    return false;
+  }
+
+  return true;
+}
+
+static void cacheTexture(const bs::String& texture, const VDFS::FileIndex& vdfs,
+                         const CacheOptions& options)
+{
+  if (HasCachedTexture(texture, vdfs)) return;
+
+  if (!recordOutdated(texture, options)) return;
+
+  ImportAndCacheTexture(texture, vdfs);
+}
+
+static void recordFailure(const bs::String& file, const bs::String& reason)
+{
+  BS_LOG(Error, Uncategorized, "Failed to cache {0}: {1}", file, reason);
+
+  Lock lock(s_FailuresMutex);
+  s_Failures.push_back({file, reason});
+}
+
+/**
+ * Imports a single model script, turning anything going wrong into a failure record and
+ * putting the model into quarantine. The importer logs why a model is broken and returns an
+ * empty handle, exceptions can still come out of ZenLib.
+ */
+static void cacheModelScript(const bs::String& mdsFile, const VDFS::FileIndex& vdfs,
+                             const CacheOptions& options)
+{
+  if (HasCachedMDS(mdsFile, vdfs)) return;
+
+  if (isQuarantined(mdsFile, vdfs))
+  {
+    BS_LOG(Warning, Uncategorized, "Skipping quarantined model: " + mdsFile);
+    return;
+  }
+
+  if (!recordOutdated(mdsFile, options)) return;
+
+  try
+  {
+    if (ImportAndCacheMDS(mdsFile, vdfs)) return;
+
+    recordFailure(mdsFile, "Model script or hierarchy is broken");
+  }
+  catch (const bs::Exception& e)
+  {
+    recordFailure(mdsFile, e.getFullDescription());
+  }
+  catch (const std::exception& e)
+  {
+    recordFailure(mdsFile, e.what());
+  }
+
+  quarantine(mdsFile, vdfs);
+}
+
+/**
+ * @return Whether the model failed to import before and neither it nor the importer changed.
+ */
+static bool isQuarantined(const bs::String& mdsFile, const VDFS::FileIndex& vdfs)
+{
+  CacheSourceStamp stamp;
+  if (!MakeCacheSourceStamp(mdsFile, vdfs, GetSkeletalMeshImporterVersion(), stamp)) return false;
+
+  Lock lock(s_QuarantineMutex);
+
+  auto it = s_Quarantine.find(mdsFile);
+
+  return it != s_Quarantine.end() && it->second == stamp;
+}
+
+static void quarantine(const bs::String& mdsFile, const VDFS::FileIndex& vdfs)
+{
+  CacheSourceStamp stamp;
+  if (!MakeCacheSourceStamp(mdsFile, vdfs, GetSkeletalMeshImporterVersion(), stamp)) return;
+
+  Lock lock(s_QuarantineMutex);
+  s_Quarantine[mdsFile] = stamp;
+}
+
+static Path quarantineFilePath()
+{
+  return GetCacheDirectory() + Path(QUARANTINE_FILE);
+}
+
+static void loadQuarantine()
+{
+  Lock lock(s_QuarantineMutex);
+
+  s_Quarantine.clear();
+
+  LineRecordReader records;
+
+  if (!records.open(quarantineFilePath())) return;
+
+  while (records.nextRecord())
+  {
+    // Format: <hash> <version> <file inside the VDFS>
+    CacheSourceStamp stamp;
+
+    if (!records.read(stamp.sourceHash) || !records.read(stamp.importerVersion)) continue;
+
+    String file = records.readRest();
+
+    if (!file.empty()) s_Quarantine[file] = stamp;
+  }
+}
+
+static void saveQuarantine()
+{
+  Lock lock(s_QuarantineMutex);
+
+  LineRecordWriter records;
+
+  for (const auto& entry : s_Quarantine)
+  {
+    records.write(entry.second.sourceHash);
+    records.write(entry.second.importerVersion);
+    records.endRecord(entry.first);
+  }
+
+  if (!records.save(quarantineFilePath()))
+  {
+    BS_LOG(Error, Uncategorized, "Could not write quarantine list to {0}", quarantineFilePath());
+  }
+}
+
 static bool hasExtension(const bs::String& file, const bs::String& ext)
 {
   return file.find(ext) != bs::String::npos;
 }
 
-static void cacheAll(const VDFS::FileIndex& vdfs, const bs::String& ext,
-                     const std::function<void(const bs::String&)>& fn)
+static bs::Vector<bs::String> knownFilesUpperCase(const VDFS::FileIndex& vdfs)
 {
-  bs::Vector<bs::SPtr<bs::Task>> tasks;
+  bs::Vector<bs::String> files;
 
   for (std::string file_ : vdfs.getKnownFiles())
   {
     bs::String file = file_.c_str();
     bs::StringUtil::toUpperCase(file);
 
-    if (hasExtension(file, ext))
-    {
-      tasks.push_back(bs::Task::create(file.c_str(), [fn, file]() { fn(file); }));
-    }
+    files.push_back(file);
   }
 
-  for (auto& task : tasks)
+  return files;
+}
+
+/**
+ * Materials refer to their textures by the uncompiled name (ie. "STONE.TGA"), in any case.
+ */
+static bs::String textureKey(const bs::String& texture)
+{
+  bs::String upper = texture;
+  bs::StringUtil::toUpperCase(upper);
+
+  return "TEX:" + upper;
+}
+
+/**
+ * Reads the given compiled static mesh (.MRM) and adds nodes for its materials and itself,
+ * unless an up to date version has been cached already.
+ */
+static void scanStaticMesh(ImportGraph& graph, const bs::String& compiledFile,
+                           const VDFS::FileIndex& vdfs, const CacheOptions& options)
+{
+  String meshName = StringUtil::replaceAll(compiledFile, ".MRM", ".3DS");
+
+  CacheSourceStamp stamp;
+  if (!MakeCacheSourceStamp(compiledFile, vdfs, GetStaticMeshImporterVersion(), stamp)) return;
+
+  if (HasCachedResource(GothicPathToCachedStaticMesh(meshName), stamp)) return;
+
+  if (!recordOutdated(meshName, options)) return;
+
+  ZenLoad::zCProgMeshProto progMesh(compiledFile.c_str(), vdfs);
+
+  if (progMesh.getNumSubmeshes() == 0)
   {
-    bs::TaskScheduler::instance().addTask(task);
+    BS_LOG(Warning, Uncategorized, "Load Failed (Mesh): " + meshName);
+    return;
   }
 
-  for (auto& task : tasks)
+  SPtr<ZenLoad::PackedMesh> packedMesh = bs_shared_ptr_new<ZenLoad::PackedMesh>();
+  progMesh.packMesh(*packedMesh, 0.01f);
+
+  addStaticMeshNodes(graph, meshName, packedMesh, stamp, vdfs);
+}
+
+/**
+ * Reads the world mesh of the given ZEN and adds nodes for its materials and itself, unless
+ * an up to date version has been cached already. The same goes for its chunks, if world
+ * meshes are split (see SetWorldChunkSize()).
+ *
+ * The world mesh is cached under the same name ImportZEN() uses for it.
+ */
+static void scanWorld(ImportGraph& graph, const bs::String& zen, const VDFS::FileIndex& vdfs,
+                      const CacheOptions& options)
+{
+  String meshName = zen + ".worldmesh";
+
+  CacheSourceStamp stamp;
+  if (!MakeCacheSourceStamp(zen, vdfs, GetStaticMeshImporterVersion(), stamp)) return;
+
+  bool isMeshUpToDate = HasCachedResource(GothicPathToCachedStaticMesh(meshName), stamp);
+
+  // Chunks are built from the same source, so they are outdated whenever the mesh is
+  bool needsChunks =
+      GetWorldChunkSize() > 0.0f && (!isMeshUpToDate || !HasCachedWorldChunks(zen, stamp));
+
+  if (isMeshUpToDate && !needsChunks) return;
+
+  if (!recordOutdated(zen, options)) return;
+
+  ZenLoad::ZenParser zenParser(zen.c_str(), vdfs);
+
+  if (zenParser.getFileSize() == 0) return;
+
+  zenParser.readHeader();
+
+  ZenLoad::oCWorldData world;
+  zenParser.readWorld(world);
+
+  if (!zenParser.getWorldMesh())
   {
-    task->wait();
+    BS_LOG(Warning, Uncategorized, "Load Failed (World Mesh): " + zen);
+    return;
   }
+
+  SPtr<ZenLoad::PackedMesh> packedMesh = bs_shared_ptr_new<ZenLoad::PackedMesh>();
+  zenParser.getWorldMesh()->packMesh(*packedMesh, 0.01f);
+
+  if (!isMeshUpToDate) addStaticMeshNodes(graph, meshName, packedMesh, stamp, vdfs);
+
+  if (needsChunks) addWorldChunksNode(graph, zen, packedMesh, stamp);
 }
 
-void BsZenLib::CacheWholeVDFS(const VDFS::FileIndex& vdfs)
+/**
+ * Adds a node splitting the given world mesh into chunks, which runs once the world mesh and
+ * its materials have been cached. Chunks share those materials instead of importing their own.
+ */
+static void addWorldChunksNode(ImportGraph& graph, const bs::String& zen,
+                               SPtr<ZenLoad::PackedMesh> packedMesh,
+                               const CacheSourceStamp& stamp)
 {
-  auto textures = [&](const bs::String& file) {
-    bs::String uncompiled = bs::StringUtil::replaceAll(file, "-C.TEX", ".TGA");
+  String meshName = zen + ".worldmesh";
+
+  graph.add("CHUNKS:" + zen, {"MESH:" + meshName}, [packedMesh, zen, meshName, stamp]() {
+    Vector<HMaterial> materials;
 
-    if (!HasCachedTexture(uncompiled))
+    for (UINT32 i = 0; i < (UINT32)packedMesh->subMeshes.size(); i++)
     {
-      ImportAndCacheTexture(uncompiled, vdfs);
+      materials.push_back(LoadCachedMaterial(BuildMaterialNameForSubmesh(meshName, i)));
     }
-  };
 
-  auto staticMeshes = [&](const bs::String& file) {
-    bs::String uncompiled = bs::StringUtil::replaceAll(file, ".MRM", ".3DS");
+    ImportAndCacheWorldChunks(zen, *packedMesh, materials, stamp);
+  });
+}
 
-    if (!HasCachedStaticMesh(uncompiled))
-    {
-      ImportAndCacheStaticMesh(uncompiled, vdfs);
-    }
-  };
+/**
+ * Adds a node for every material of the given mesh, depending on the texture it uses, and
+ * one for the mesh itself, depending on all of its materials.
+ */
+static void addStaticMeshNodes(ImportGraph& graph, const bs::String& meshName,
+                               SPtr<ZenLoad::PackedMesh> packedMesh,
+                               const CacheSourceStamp& stamp, const VDFS::FileIndex& vdfs)
+{
+  // Every material node writes into its own slot only
+  auto materials = bs_shared_ptr_new<Vector<HMaterial>>(packedMesh->subMeshes.size());
 
-  auto skeletalMeshes = [&](const bs::String& file) {
-    // MDS is not compiled, keep extension
+  Vector<String> materialKeys;
 
-    if (!HasCachedMDS(file))
-    {
-      ImportAndCacheMDS(file, vdfs);
-    }
-  };
+  for (UINT32 i = 0; i < (UINT32)packedMesh->subMeshes.size(); i++)
+  {
+    const ZenLoad::zCMaterialData& material = packedMesh->subMeshes[i].material;
 
-  cacheAll(vdfs, ".TEX", textures);
-  cacheAll(vdfs, ".MRM", staticMeshes);
+    String materialName = BuildMaterialNameForSubmesh(meshName, i);
+    String materialKey = "MAT:" + materialName;
 
-  // FIXME: There seems to be a problem with SHEEP in Gothic 2, therefore MDS is commented out
-  // cacheAll(vdfs, ".MDS", skeletalMeshes);
+    graph.add(materialKey, {textureKey(material.texture.c_str())},
+              [&vdfs, packedMesh, materials, materialName, i]() {
+                const auto& original = packedMesh->subMeshes[i].material;
+
+                (*materials)[i] = ImportAndCacheMaterialWithTextures(materialName, original, vdfs);
+              });
+
+    materialKeys.push_back(materialKey);
+  }
+
+  graph.add("MESH:" + meshName, materialKeys, [packedMesh, materials, meshName, stamp]() {
+    BS_LOG(Info, Uncategorized, "Caching Static Mesh: " + meshName);
+
+    if (!ImportAndCacheStaticMesh(meshName, *packedMesh, *materials, stamp))
+    {
+      recordFailure(meshName, "Mesh or one of its materials could not be imported");
+    }
+  });
 }
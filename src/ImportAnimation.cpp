@@ -1,8 +1,11 @@
 #include "ImportAnimation.hpp"
+#include "CachePack.hpp"
+#include "ImportMetrics.hpp"
 
 #include "ImportPath.hpp"
 #include "ImportSkeletalMesh.hpp"
 #include "ResourceManifest.hpp"
+#include "ScratchBuffer.hpp"
 
 #include <Animation/BsAnimationClip.h>
 #include <Animation/BsAnimationUtility.h>
@@ -39,19 +42,10 @@ static Matrix4 convertMatrix(const ZMath::Matrix& m);
 static int32_t scaleFrameToHeaderFrameRate(const ZenLoad::zCModelScriptAni& ani, size_t frame,
                                            size_t numFramesTotal);
 
-struct AnimationCurvesWithRootMotion
-{
-  bs::AnimationCurves curves;
-  bs::RootMotion rootMotion;
-};
-
 static AnimationCurvesWithRootMotion importAnimationSamples(const String& virtualFilePath,
                                                             const ZenLoad::zCModelMeshLib& meshLib,
                                                             const ZenLoad::zCModelScriptAni& def,
                                                             const VDFS::FileIndex& vdfs);
-static AnimationCurvesWithRootMotion convertSamples(const std::vector<ZenLoad::ModelNode>& nodes,
-                                                    const ZenLoad::zCModelScriptAni& def,
-                                                    const ZenLoad::ModelAnimationParser& parser);
 
 bool BsZenLib::HasCachedMAN(const bs::String& fullAnimationName)
 {
@@ -60,7 +54,7 @@ bool BsZenLib::HasCachedMAN(const bs::String& fullAnimationName)
 
 Res::HZAnimation BsZenLib::LoadCachedAnimation(const bs::String& fullAnimationName)
 {
-  return bs::gResources().load<ZAnimationClip>(GothicPathToCachedZAnimation(fullAnimationName));
+  return LoadCachedResource<ZAnimationClip>(GothicPathToCachedZAnimation(fullAnimationName));
 }
 
 Res::HZAnimation BsZenLib::ImportMAN(const ZenLoad::zCModelMeshLib& meshLib,
@@ -132,6 +126,8 @@ Res::HZAnimation BsZenLib::ImportMAN(const ZenLoad::zCModelMeshLib& meshLib,
   clip->setName(def.fullAnimationName);
   anim->setName(def.fullAnimationName);
 
+  ScopedImportTimer timer("Animation", "Save", def.fullAnimationName);
+
   const bool overwrite = true;
   gResources().save(clip, GothicPathToCachedAnimationClip(def.fullAnimationName), overwrite);
   AddToResourceManifest(clip, GothicPathToCachedAnimationClip(def.fullAnimationName));
@@ -139,6 +135,8 @@ Res::HZAnimation BsZenLib::ImportMAN(const ZenLoad::zCModelMeshLib& meshLib,
   gResources().save(anim, GothicPathToCachedZAnimation(def.fullAnimationName), overwrite);
   AddToResourceManifest(anim, GothicPathToCachedZAnimation(def.fullAnimationName));
 
+  timer.setBytesOutFromFile(GothicPathToCachedAnimationClip(def.fullAnimationName));
+
   return anim;
 }
 
@@ -266,17 +264,22 @@ static AnimationCurvesWithRootMotion importAnimationSamples(const String& manFil
     }
   }
 
-  return convertSamples(meshLib.getNodes(), def, parser);
+  ScopedImportTimer timer("Animation", "ConvertSamples", manFile);
+  timer.setBytesIn(parser.getSamples().size() * sizeof(ZenLoad::zCModelAniSample));
+
+  return ConvertAnimationSamples(meshLib.getNodes(), def, parser.getHeader(),
+                                 parser.getNodeIndex(), parser.getSamples());
 }
 
-static AnimationCurvesWithRootMotion convertSamples(const std::vector<ZenLoad::ModelNode>& nodes,
-                                                    const ZenLoad::zCModelScriptAni& def,
-                                                    const ZenLoad::ModelAnimationParser& parser)
+AnimationCurvesWithRootMotion BsZenLib::ConvertAnimationSamples(
+    const std::vector<ZenLoad::ModelNode>& nodes, const ZenLoad::zCModelScriptAni& def,
+    const ZenLoad::zCModelAniHeader& header, const std::vector<uint32_t>& nodeIndex,
+    const std::vector<ZenLoad::zCModelAniSample>& samples)
 {
   AnimationCurvesWithRootMotion result = {};
 
-  size_t numFrames = parser.getHeader().numFrames;
-  size_t numNodesInAnimation = parser.getNodeIndex().size();
+  size_t numFrames = header.numFrames;
+  size_t numNodesInAnimation = nodeIndex.size();
 
   size_t startFrame = 0;
   size_t lastFrame = numFrames - 1;
@@ -289,10 +292,17 @@ static AnimationCurvesWithRootMotion convertSamples(const std::vector<ZenLoad::M
     return {};
   }
 
+  // Reused for every node, the curves copy the keyframes
+  ScratchBuffer<Vector<TKeyframe<Vector3>>> positionScratch;
+  ScratchBuffer<Vector<TKeyframe<Quaternion>>> rotationScratch;
+
+  Vector<TKeyframe<Vector3>>& positionKeyframes = *positionScratch;
+  Vector<TKeyframe<Quaternion>>& rotationKeyframes = *rotationScratch;
+
   Vector<bool> animatedNodes(nodes.size(), false);
   for (size_t nodeIdx = 0; nodeIdx < numNodesInAnimation; nodeIdx++)
   {
-    size_t realNodeIdx = parser.getNodeIndex()[nodeIdx];
+    size_t realNodeIdx = nodeIndex[nodeIdx];
 
     // if (realNodeIdx != 0)
     // continue;
@@ -303,8 +313,9 @@ static AnimationCurvesWithRootMotion convertSamples(const std::vector<ZenLoad::M
 
     const ZenLoad::ModelNode& node = nodes[realNodeIdx];
 
-    Vector<TKeyframe<Vector3>> positionKeyframes(numFrames);
-    Vector<TKeyframe<Quaternion>> rotationKeyframes(numFrames);
+    // Every field of every frame is written below
+    positionKeyframes.resize(numFrames);
+    rotationKeyframes.resize(numFrames);
 
     for (size_t frame = 0; frame < numFrames; frame++)
     {
@@ -325,7 +336,7 @@ static AnimationCurvesWithRootMotion convertSamples(const std::vector<ZenLoad::M
       // to get to the next frame.
       size_t realFrame = frameIdx + startFrame;
       size_t sampleIdx = numNodesInAnimation * realFrame + nodeIdx;
-      const ZenLoad::zCModelAniSample& sample = parser.getSamples()[sampleIdx];
+      const ZenLoad::zCModelAniSample& sample = samples[sampleIdx];
 
       Vector4 sdfsd;
       Vector3 position = Vector3(sample.position.x,   // ...
@@ -341,7 +352,7 @@ static AnimationCurvesWithRootMotion convertSamples(const std::vector<ZenLoad::M
       // rotation.fromRotationMatrix(workaround);
 
       // TODO: Find out whether these are seconds, milliseconds, ...?
-      float keyframeTime = frame / parser.getHeader().fpsRate;
+      float keyframeTime = frame / header.fpsRate;
 
       positionKeyframes[frame].inTangent = Vector3(BsZero);
       positionKeyframes[frame].outTangent = Vector3(BsZero);
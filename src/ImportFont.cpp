@@ -1,7 +1,9 @@
 #include "ResourceManifest.hpp"
+#include <BsZenLib/CachePack.hpp>
 #include <BsZenLib/ImportFont.hpp>
 #include <BsZenLib/ImportPath.hpp>
 #include <BsZenLib/ImportTexture.hpp>
+#include <BsZenLib/InFlightImports.hpp>
 #include <FileSystem/BsFileSystem.h>
 #include <Math/BsVector2.h>
 #include <Resources/BsResources.h>
@@ -79,15 +81,18 @@ private:
   bs::HTexture importFontBitmap()
   {
     bs::String fontBitmapFile = getFontTextureFileName();
-
-    if (BsZenLib::HasCachedTexture(fontBitmapFile))
-    {
-      return BsZenLib::LoadCachedTexture(fontBitmapFile);
-    }
-    else
-    {
-      return BsZenLib::ImportAndCacheTexture(fontBitmapFile, mFileIndex);
-    }
+    bs::Path path = BsZenLib::GothicPathToCachedTexture(fontBitmapFile);
+
+    return BsZenLib::ImportOnce<bs::Texture>(path, [&]() {
+      if (BsZenLib::HasCachedTexture(fontBitmapFile))
+      {
+        return BsZenLib::LoadCachedTexture(fontBitmapFile);
+      }
+      else
+      {
+        return BsZenLib::ImportAndCacheTexture(fontBitmapFile, mFileIndex);
+      }
+    });
   }
 
   /**
@@ -131,25 +136,27 @@ private:
 bs::HFont BsZenLib::ImportAndCacheFont(const bs::String& originalFileName,
                                        const VDFS::FileIndex& vdfs)
 {
-  ImportFont importer(originalFileName, vdfs);
+  return ImportOnce<bs::Font>(GothicPathToCachedFont(originalFileName), [&]() -> bs::HFont {
+    ImportFont importer(originalFileName, vdfs);
 
-  if (!importer.hasLoadSucceeded())
-  {
-    return {};
-  }
+    if (!importer.hasLoadSucceeded())
+    {
+      return {};
+    }
 
-  bs::HFont font = importer.constructFont();
+    bs::HFont font = importer.constructFont();
 
-  const bool overwrite = true;
-  bs::gResources().save(font, GothicPathToCachedFont(originalFileName), overwrite);
-  AddToResourceManifest(font, GothicPathToCachedFont(originalFileName));
+    const bool overwrite = true;
+    bs::gResources().save(font, GothicPathToCachedFont(originalFileName), overwrite);
+    AddToResourceManifest(font, GothicPathToCachedFont(originalFileName));
 
-  return font;
+    return font;
+  });
 }
 
 bs::HFont BsZenLib::LoadCachedFont(const bs::String& originalFileName)
 {
-  return bs::gResources().load<bs::Font>(GothicPathToCachedFont(originalFileName));
+  return LoadCachedResource<bs::Font>(GothicPathToCachedFont(originalFileName));
 }
 
 bool BsZenLib::HasCachedFont(const bs::String& originalFileName)
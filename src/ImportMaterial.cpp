@@ -1,7 +1,11 @@
 #include "ImportMaterial.hpp"
+#include "CachePack.hpp"
+#include "ImportMetrics.hpp"
 #include "ImportPath.hpp"
 #include "ImportTexture.hpp"
+#include "InFlightImports.hpp"
 #include "ResourceManifest.hpp"
+#include "TextureStreaming.hpp"
 #include <FileSystem/BsFileSystem.h>
 #include <Importer/BsImporter.h>
 #include <Material/BsMaterial.h>
@@ -19,6 +23,9 @@ using namespace bs;
  */
 bs::Map<BsZenLib::ShaderKind, bs::HShader> s_ShadersByKind;
 
+static HMaterial importAndCacheMaterialWithTextures(const String& cacheName,
+                                                    const ZenLoad::zCMaterialData& material,
+                                                    const VDFS::FileIndex& vdfs);
 static HTexture loadOrCacheTexture(const String& virtualFilePath, const VDFS::FileIndex& vdfs);
 static BsZenLib::ShaderKind guessShaderKindFromZMaterial(const ZenLoad::zCMaterialData& mat);
 
@@ -85,37 +92,80 @@ HMaterial BsZenLib::ImportAndCacheMaterialWithTextures(const String& cacheName,
                                                        const ZenLoad::zCMaterialData& material,
                                                        const VDFS::FileIndex& vdfs)
 {
+  return ImportOnce<Material>(GothicPathToCachedMaterial(cacheName), [&]() {
+    return importAndCacheMaterialWithTextures(cacheName, material, vdfs);
+  });
+}
+
+static HMaterial importAndCacheMaterialWithTextures(const String& cacheName,
+                                                    const ZenLoad::zCMaterialData& material,
+                                                    const VDFS::FileIndex& vdfs)
+{
+  using namespace BsZenLib;
+
   HShader shader = getShaderForZMaterial(material);
 
   HMaterial bsfMaterial = Material::create(shader);
 
-  // Load Textures
-  HTexture albedo = loadOrCacheTexture(material.texture.c_str(), vdfs);
+  // Load Textures. With streaming, the full texture gets streamed in later, see
+  // RequestMaterialDetail(), so only its tail is loaded if it is cached already.
+  HTexture albedo;
+
+  if (IsTextureStreamingEnabled() && HasCachedTexture(material.texture.c_str()))
+  {
+    albedo = LoadCachedTextureTail(material.texture.c_str());
+  }
+  else
+  {
+    albedo = loadOrCacheTexture(material.texture.c_str(), vdfs);
+
+    if (albedo && IsTextureStreamingEnabled())
+    {
+      albedo = LoadCachedTextureTail(material.texture.c_str());
+    }
+  }
+
   bsfMaterial->setTexture("gAlbedoTex", albedo);
 
   // Save to cache
+  ScopedImportTimer timer("Material", "Save", cacheName);
+
   const bool overwrite = true;
   gResources().save(bsfMaterial, GothicPathToCachedMaterial(cacheName), overwrite);
   AddToResourceManifest(bsfMaterial, GothicPathToCachedMaterial(cacheName));
 
+  timer.setBytesOutFromFile(GothicPathToCachedMaterial(cacheName));
+
   return bsfMaterial;
 }
 
+/**
+ * Checking and importing happens inside ImportOnce(), so a texture finished by another thread
+ * right after checking is not imported again.
+ *
+ * Only checks whether the texture is cached, not whether it is up to date: Checking that means
+ * reading the whole texture from the VDFS. CacheWholeVDFS() brings textures up to date before
+ * any material needs them.
+ */
 static HTexture loadOrCacheTexture(const String& virtualFilePath, const VDFS::FileIndex& vdfs)
 {
-  if (BsZenLib::HasCachedTexture(virtualFilePath))
-  {
-    return BsZenLib::LoadCachedTexture(virtualFilePath);
-  }
-  else
-  {
-    return BsZenLib::ImportAndCacheTexture(virtualFilePath, vdfs);
-  }
+  Path path = BsZenLib::GothicPathToCachedTexture(virtualFilePath);
+
+  return BsZenLib::ImportOnce<Texture>(path, [&]() {
+    if (BsZenLib::HasCachedTexture(virtualFilePath))
+    {
+      return BsZenLib::LoadCachedTexture(virtualFilePath);
+    }
+    else
+    {
+      return BsZenLib::ImportAndCacheTexture(virtualFilePath, vdfs);
+    }
+  });
 }
 
 HMaterial BsZenLib::LoadCachedMaterial(const String& cacheName)
 {
-  return gResources().load<Material>(GothicPathToCachedMaterial(cacheName));
+  return LoadCachedResource<Material>(GothicPathToCachedMaterial(cacheName));
 }
 
 bool BsZenLib::HasCachedMaterial(const String& cacheName)
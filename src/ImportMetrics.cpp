@@ -0,0 +1,264 @@
+/**
+ * Import Metrics
+ * ==============
+ *
+ * Records are collected into a single vector guarded by a mutex. Stages take at least several
+ * microseconds of actual work each, so the lock is not worth anything more clever.
+ *
+ * Times are taken from a steady clock and stored relative to the first record, which is also
+ * what the Chrome trace format expects.
+ */
+
+#include "ImportMetrics.hpp"
+#include <atomic>
+#include <chrono>
+#include <FileSystem/BsDataStream.h>
+#include <FileSystem/BsFileSystem.h>
+#include <Threading/BsThreading.h>
+
+using namespace bs;
+using namespace BsZenLib;
+
+using MetricsClock = std::chrono::steady_clock;
+
+static std::atomic<bool> s_IsEnabled{false};
+static Mutex s_RecordsMutex;
+static Vector<ImportStageRecord> s_Records;
+
+static UINT64 microsecondsSinceEpoch();
+static UINT32 currentThreadId();
+static String escapeJSON(const String& in);
+static bool writeFile(const Path& file, const String& contents);
+
+// - Implementation --------------------------------------------------------------------------------
+
+BsZenLib::ScopedImportTimer::ScopedImportTimer(const char* assetType, const char* stage,
+                                               const bs::String& asset)
+    : mIsEnabled(s_IsEnabled.load(std::memory_order_relaxed))
+{
+  if (!mIsEnabled) return;
+
+  mRecord.assetType = assetType;
+  mRecord.stage = stage;
+  mRecord.asset = asset;
+  mRecord.threadId = currentThreadId();
+  mRecord.startMicroseconds = microsecondsSinceEpoch();
+}
+
+BsZenLib::ScopedImportTimer::~ScopedImportTimer()
+{
+  if (!mIsEnabled) return;
+
+  mRecord.durationMicroseconds = microsecondsSinceEpoch() - mRecord.startMicroseconds;
+
+  Lock lock(s_RecordsMutex);
+  s_Records.push_back(std::move(mRecord));
+}
+
+void BsZenLib::ScopedImportTimer::setBytesOutFromFile(const bs::Path& file)
+{
+  if (!mIsEnabled) return;
+
+  mRecord.bytesOut = FileSystem::getFileSize(file);
+}
+
+void BsZenLib::SetImportMetricsEnabled(bool enabled)
+{
+  s_IsEnabled.store(enabled);
+}
+
+bool BsZenLib::IsImportMetricsEnabled()
+{
+  return s_IsEnabled.load();
+}
+
+void BsZenLib::ResetImportMetrics()
+{
+  Lock lock(s_RecordsMutex);
+  s_Records.clear();
+}
+
+bs::Vector<ImportStageRecord> BsZenLib::GetImportStageRecords()
+{
+  Lock lock(s_RecordsMutex);
+
+  return s_Records;
+}
+
+bs::Vector<ImportStageTotal> BsZenLib::GetImportStageTotals()
+{
+  Vector<ImportStageTotal> totals;
+  Map<std::pair<String, String>, size_t> indexByStage;
+
+  Lock lock(s_RecordsMutex);
+
+  for (const ImportStageRecord& record : s_Records)
+  {
+    auto key = std::make_pair(String(record.assetType), String(record.stage));
+    auto it = indexByStage.find(key);
+
+    if (it == indexByStage.end())
+    {
+      it = indexByStage.insert(std::make_pair(key, totals.size())).first;
+
+      totals.emplace_back();
+      totals.back().assetType = record.assetType;
+      totals.back().stage = record.stage;
+    }
+
+    ImportStageTotal& total = totals[it->second];
+    total.count++;
+    total.durationMicroseconds += record.durationMicroseconds;
+    total.bytesIn += record.bytesIn;
+    total.bytesOut += record.bytesOut;
+  }
+
+  return totals;
+}
+
+bool BsZenLib::SaveImportMetricsJSON(const bs::Path& file)
+{
+  Vector<ImportStageTotal> totals = GetImportStageTotals();
+  Vector<ImportStageRecord> records = GetImportStageRecords();
+
+  StringStream out;
+
+  out << "{\n  \"totals\": [";
+
+  for (size_t i = 0; i < totals.size(); i++)
+  {
+    const ImportStageTotal& t = totals[i];
+
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\"assetType\": \"" << t.assetType << "\", \"stage\": \"" << t.stage
+        << "\", \"count\": " << t.count << ", \"durationUs\": " << t.durationMicroseconds
+        << ", \"bytesIn\": " << t.bytesIn << ", \"bytesOut\": " << t.bytesOut << "}";
+  }
+
+  out << "\n  ],\n  \"records\": [";
+
+  for (size_t i = 0; i < records.size(); i++)
+  {
+    const ImportStageRecord& r = records[i];
+
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\"assetType\": \"" << r.assetType << "\", \"stage\": \"" << r.stage
+        << "\", \"asset\": \"" << escapeJSON(r.asset) << "\", \"startUs\": " << r.startMicroseconds
+        << ", \"durationUs\": " << r.durationMicroseconds << ", \"bytesIn\": " << r.bytesIn
+        << ", \"bytesOut\": " << r.bytesOut << ", \"threadId\": " << r.threadId;
+
+    if (*r.measure)
+    {
+      out << ", \"measure\": \"" << r.measure << "\", \"before\": " << r.measureBefore
+          << ", \"after\": " << r.measureAfter;
+    }
+
+    out << "}";
+  }
+
+  out << "\n  ]\n}\n";
+
+  return writeFile(file, out.str());
+}
+
+bool BsZenLib::SaveImportMetricsChromeTrace(const bs::Path& file)
+{
+  Vector<ImportStageRecord> records = GetImportStageRecords();
+
+  StringStream out;
+
+  out << "{\"traceEvents\": [";
+
+  for (size_t i = 0; i < records.size(); i++)
+  {
+    const ImportStageRecord& r = records[i];
+
+    // Complete events ("X") carry their own duration, so no begin/end pairs are needed
+    out << (i == 0 ? "\n" : ",\n");
+    out << "  {\"name\": \"" << r.assetType << "::" << r.stage << "\", \"cat\": \""
+        << r.assetType << "\", \"ph\": \"X\", \"ts\": " << r.startMicroseconds
+        << ", \"dur\": " << r.durationMicroseconds << ", \"pid\": 1, \"tid\": " << r.threadId
+        << ", \"args\": {\"asset\": \"" << escapeJSON(r.asset) << "\", \"bytesIn\": " << r.bytesIn
+        << ", \"bytesOut\": " << r.bytesOut;
+
+    if (*r.measure)
+    {
+      out << ", \"" << r.measure << "Before\": " << r.measureBefore << ", \"" << r.measure
+          << "After\": " << r.measureAfter;
+    }
+
+    out << "}}";
+  }
+
+  out << "\n]}\n";
+
+  return writeFile(file, out.str());
+}
+
+static UINT64 microsecondsSinceEpoch()
+{
+  static const MetricsClock::time_point s_Epoch = MetricsClock::now();
+
+  auto elapsed = MetricsClock::now() - s_Epoch;
+
+  return (UINT64)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+/**
+ * Native thread ids are large and not very readable in a trace, so hand out small ones.
+ */
+static UINT32 currentThreadId()
+{
+  static std::atomic<UINT32> s_NextThreadId{1};
+  static thread_local UINT32 s_ThreadId = s_NextThreadId.fetch_add(1);
+
+  return s_ThreadId;
+}
+
+static String escapeJSON(const String& in)
+{
+  String out;
+  out.reserve(in.size());
+
+  for (char c : in)
+  {
+    switch (c)
+    {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if ((UINT8)c < 0x20) continue;  // Other control characters don't appear in file names
+
+        out += c;
+        break;
+    }
+  }
+
+  return out;
+}
+
+static bool writeFile(const Path& file, const String& contents)
+{
+  SPtr<DataStream> stream = FileSystem::createAndOpenFile(file);
+
+  if (!stream)
+  {
+    BS_LOG(Error, Uncategorized, "Could not write import metrics to {0}", file);
+    return false;
+  }
+
+  stream->writeString(contents);
+  stream->close();
+
+  return true;
+}
@@ -15,6 +15,11 @@ bs::Path BsZenLib::GothicPathToCachedTexture(const bs::String& virtualFilePath)
   return GetCacheDirectory() + Path("textures") + Path(virtualFilePath + ".asset");
 }
 
+bs::Path BsZenLib::GothicPathToCachedTextureTail(const bs::String& virtualFilePath)
+{
+  return GetCacheDirectory() + Path("texture-tails") + Path(virtualFilePath + ".asset");
+}
+
 bs::Path BsZenLib::GothicPathToCachedMaterial(const bs::String& virtualFilePath)
 {
   return GetCacheDirectory() + Path("materials") + Path(virtualFilePath + ".asset");
@@ -55,6 +60,11 @@ bs::Path BsZenLib::GothicPathToCachedWorld(const bs::String& worldName)
   return GetCacheDirectory() + Path("worlds") + Path(worldName + ".asset");
 }
 
+bs::Path BsZenLib::GothicPathToCachedWorldChunks(const bs::String& worldName)
+{
+  return GetCacheDirectory() + Path("worlds") + Path(worldName + ".chunks");
+}
+
 bs::Path BsZenLib::GothicPathToCachedFont(const bs::String& virtualFilePath)
 {
   return GetCacheDirectory() + Path("fonts") + Path(virtualFilePath + ".asset");
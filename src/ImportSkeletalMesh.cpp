@@ -1,10 +1,16 @@
 #include "ImportSkeletalMesh.hpp"
 #include <optional>
+#include "CachePack.hpp"
 #include "ImportAnimation.hpp"
 #include "ImportMaterial.hpp"
+#include "ImportMetrics.hpp"
 #include "ImportPath.hpp"
 #include "ImportStaticMesh.hpp"
+#include "InFlightImports.hpp"
+#include "MeshIndices.hpp"
 #include "ResourceManifest.hpp"
+#include "ScratchBuffer.hpp"
+#include "TextureStreaming.hpp"
 #include <Animation/BsSkeleton.h>
 #include <Components/BsCRenderable.h>
 #include <FileSystem/BsFileSystem.h>
@@ -63,6 +69,134 @@ static bs::String stripExtension(const bs::String& in)
   return in.substr(0, in.length() - 4);
 }
 
+static SPtr<VertexDataDesc> makeVertexDataDescForSkeletalVertex()
+{
+  SPtr<VertexDataDesc> vertexDataDesc = VertexDataDesc::create();
+  vertexDataDesc->addVertElem(VET_FLOAT3, VES_POSITION);
+  vertexDataDesc->addVertElem(VET_FLOAT3, VES_NORMAL);
+  vertexDataDesc->addVertElem(VET_FLOAT2, VES_TEXCOORD);
+  vertexDataDesc->addVertElem(VET_COLOR, VES_COLOR);
+  vertexDataDesc->addVertElem(VET_FLOAT3, VES_TANGENT);
+  vertexDataDesc->addVertElem(VET_FLOAT3, VES_BITANGENT);
+  vertexDataDesc->addVertElem(VET_UBYTE4, VES_BLEND_INDICES);
+  vertexDataDesc->addVertElem(VET_FLOAT4, VES_BLEND_WEIGHTS);
+  // vertexDataDesc->addVertElem(VET_UBYTE4, VES_TEXCOORD, 1);
+  // vertexDataDesc->addVertElem(VET_FLOAT4, VES_TEXCOORD, 2);
+
+  assert(vertexDataDesc->getVertexStride() == sizeof(SkeletalVertex));
+
+  return vertexDataDesc;
+}
+
+static Vector3 transformToBindPose(const ZenLoad::SkeletalVertex& vertex,
+                                   const Vector<Matrix4>& bindPose)
+{
+  Vector3 transformed = Vector3(0.0f, 0.0f, 0.0f);
+
+  for (size_t i = 0; i < 4; i++)
+  {
+    Vector3 localPosition = Vector3(vertex.LocalPositions[i].x, vertex.LocalPositions[i].y,
+                                    vertex.LocalPositions[i].z);
+
+    Vector4 tmp = bindPose[vertex.BoneIndices[i]].multiply(Vector4(localPosition, 1.0f));
+    transformed += Vector3(tmp) * vertex.Weights[i];
+  }
+
+  return transformed;
+}
+
+/**
+ * Converts the vertices from ZenLib into a format for bs::f.
+ */
+static void transformVertices(const ZenLoad::PackedSkeletalMesh& packedMesh,
+                              const Vector<Matrix4>& bindPose, Vector<SkeletalVertex>& outVertices)
+{
+  outVertices.reserve(packedMesh.vertices.size());
+
+  for (const ZenLoad::SkeletalVertex& oldVertex : packedMesh.vertices)
+  {
+    SkeletalVertex newVertex = {};
+
+    newVertex.position = transformToBindPose(oldVertex, bindPose);
+    newVertex.normal = Vector3(oldVertex.Normal.x, oldVertex.Normal.y, oldVertex.Normal.z);
+    newVertex.texCoord = Vector2(oldVertex.TexCoord.x, oldVertex.TexCoord.y);
+
+    newVertex.color = oldVertex.Color;
+
+    newVertex.tangent = Vector3();
+    newVertex.bitangent = Vector3();
+
+    newVertex.boneWeights[0] = oldVertex.Weights[0];
+    newVertex.boneWeights[1] = oldVertex.Weights[1];
+    newVertex.boneWeights[2] = oldVertex.Weights[2];
+    newVertex.boneWeights[3] = oldVertex.Weights[3];
+
+    newVertex.boneIndices[0] = oldVertex.BoneIndices[0];
+    newVertex.boneIndices[1] = oldVertex.BoneIndices[1];
+    newVertex.boneIndices[2] = oldVertex.BoneIndices[2];
+    newVertex.boneIndices[3] = oldVertex.BoneIndices[3];
+
+    outVertices.push_back(newVertex);
+  }
+}
+
+static void transferVertices(SPtr<MeshData> target, const Vector<SkeletalVertex>& vertices)
+{
+  assert(target->getNumVertices() == vertices.size());
+
+  UINT8* pVertices = target->getElementData(VES_POSITION);
+  memcpy(pVertices, vertices.data(), sizeof(SkeletalVertex) * vertices.size());
+}
+
+/**
+ * Copies the indices of all submeshes, narrowing them if the target has 16-bit indices.
+ */
+static void transferIndices(SPtr<MeshData> target, const ZenLoad::PackedSkeletalMesh& packedMesh)
+{
+  size_t writtenSoFar = 0;
+
+  for (const auto& submesh : packedMesh.subMeshes)
+  {
+    if (target->getIndexType() == IT_16BIT)
+    {
+      NarrowIndices(submesh.indices.data(), &target->getIndices16()[writtenSoFar],
+                    submesh.indices.size());
+    }
+    else
+    {
+      memcpy(&target->getIndices32()[writtenSoFar], submesh.indices.data(),
+             sizeof(UINT32) * submesh.indices.size());
+    }
+
+    writtenSoFar += submesh.indices.size();
+  }
+}
+
+SPtr<MeshData> BsZenLib::ConvertSkeletalMeshData(const ZenLoad::PackedSkeletalMesh& packedMesh,
+                                                 const bs::Vector<bs::Matrix4>& bindPose)
+{
+  UINT32 numIndices = 0;
+
+  for (const auto& submesh : packedMesh.subMeshes)
+  {
+    numIndices += (UINT32)submesh.indices.size();
+  }
+
+  UINT32 numVertices = (UINT32)packedMesh.vertices.size();
+
+  SPtr<MeshData> meshData = MeshData::create(numVertices, numIndices,
+                                             makeVertexDataDescForSkeletalVertex(),
+                                             ChooseIndexType(numVertices));
+
+  ScratchBuffer<Vector<SkeletalVertex>> vertices;
+  transformVertices(packedMesh, bindPose, *vertices);
+
+  transferVertices(meshData, *vertices);
+  transferIndices(meshData, packedMesh);
+
+  return meshData;
+}
+
 /**
  * Loads a mesh used with skeletal animation, stored inside .MDL or .MDM-files.
  */
@@ -78,16 +212,24 @@ public:
   {
     if (!loadMeshSkin())
     {
-      BS_EXCEPT(InternalErrorException, "Could not load model skin: " + mdlFile);
+      BS_LOG(Error, Uncategorized, "[SkeletalMesh] Could not load model skin: " + mdlFile);
+      return;
     }
 
     packMesh();
     workaroundEmptyMesh();
-    importAndCacheGeometry();
+
+    if (!importAndCacheGeometry()) return;
+
     importAndCacheSkeletalMeshMaterials();
     importAndCacheAttachments();
   }
 
+  /**
+   * @return Whether the mesh has been imported. If not, the reason has been logged already.
+   */
+  bool isValid() const { return mImportedMesh != nullptr; }
+
   HMesh getImportedMesh() const { return mImportedMesh; }
   Vector<HMaterial> getImportedMaterials() const { return mImportedMeshMaterials; }
   Map<String, HMeshWithMaterials> getNodeAttachments() const { return mNodeAttachments; }
@@ -120,13 +262,15 @@ private:
     mPackedMesh.subMeshes.back().indices = {0, 0, 0};
   }
 
-  void importAndCacheGeometry()
+  bool importAndCacheGeometry()
   {
     MESH_DESC desc = meshDescForPackedMesh();
 
     if (desc.numIndices == 0)
     {
-      BS_EXCEPT(InternalErrorException, "Skeletal Mesh cannot have 0 indices!");
+      BS_LOG(Error, Uncategorized,
+             "[SkeletalMesh] Skeletal Mesh cannot have 0 indices: " + mMdlFile);
+      return false;
     }
 
     desc.skeleton = mSkeleton;
@@ -135,15 +279,31 @@ private:
 
     mesh->setName(mMdlFile);
 
-    Vector<SkeletalVertex> vertices = transformVertices();
+    SPtr<MeshData> meshData;
+    {
+      ScopedImportTimer timer("SkeletalMesh", "ConvertMeshData", mMdlFile);
+      meshData = ConvertSkeletalMeshData(mPackedMesh, mBindPose);
+
+      timer.setBytesIn(mPackedMesh.vertices.size() * sizeof(ZenLoad::SkeletalVertex));
+      timer.setBytesOut(meshData->getSize());
+    }
 
-    fillMeshDataFromPackedMesh(mesh, vertices);
+    {
+      ScopedImportTimer timer("SkeletalMesh", "WriteMeshData", mMdlFile);
+      mesh->writeData(meshData, false);
+    }
 
     mImportedMesh = mesh;
 
+    ScopedImportTimer timer("SkeletalMesh", "SaveGeometry", mMdlFile);
+
     const bool overwrite = true;
     gResources().save(mesh, GothicPathToCachedSkeletalMesh(mMdlFile + "-geometry"), overwrite);
     AddToResourceManifest(mesh, GothicPathToCachedSkeletalMesh(mMdlFile + "-geometry"));
+
+    timer.setBytesOutFromFile(GothicPathToCachedSkeletalMesh(mMdlFile + "-geometry"));
+
+    return true;
   }
 
   void importAndCacheSkeletalMeshMaterials()
@@ -153,18 +313,11 @@ private:
       // TODO: Transfer more properties
       const auto& originalMaterial = mPackedMesh.subMeshes[i].material;
 
-      HMaterial imported;
-
       String materialCacheFile = BuildMaterialNameForSubmesh(mMdlFile, (UINT32)i);
 
-      if (HasCachedMaterial(materialCacheFile))
-      {
-        imported = LoadCachedMaterial(materialCacheFile);
-      }
-      else
-      {
-        imported = ImportAndCacheMaterialWithTextures(materialCacheFile, originalMaterial, mVDFS);
-      }
+      // Always import, the cached material might have been built from an outdated mesh
+      HMaterial imported =
+          ImportAndCacheMaterialWithTextures(materialCacheFile, originalMaterial, mVDFS);
 
       mImportedMeshMaterials.push_back(imported);
     }
@@ -175,58 +328,6 @@ private:
     mNodeAttachments = ImportAndCacheNodeAttachments(mMdlFile, mVDFS);
   }
 
-  /**
-   * Converts the vertices from ZenLib into a format for bs::f.
-   */
-  Vector<SkeletalVertex> transformVertices()
-  {
-    Vector<SkeletalVertex> v;
-
-    for (const ZenLoad::SkeletalVertex& oldVertex : mPackedMesh.vertices)
-    {
-      SkeletalVertex newVertex = {};
-
-      newVertex.position = transformToBindPose(oldVertex);
-      newVertex.normal = Vector3(oldVertex.Normal.x, oldVertex.Normal.y, oldVertex.Normal.z);
-      newVertex.texCoord = Vector2(oldVertex.TexCoord.x, oldVertex.TexCoord.y);
-
-      newVertex.color = oldVertex.Color;
-
-      newVertex.tangent = Vector3();
-      newVertex.bitangent = Vector3();
-
-      newVertex.boneWeights[0] = oldVertex.Weights[0];
-      newVertex.boneWeights[1] = oldVertex.Weights[1];
-      newVertex.boneWeights[2] = oldVertex.Weights[2];
-      newVertex.boneWeights[3] = oldVertex.Weights[3];
-
-      newVertex.boneIndices[0] = oldVertex.BoneIndices[0];
-      newVertex.boneIndices[1] = oldVertex.BoneIndices[1];
-      newVertex.boneIndices[2] = oldVertex.BoneIndices[2];
-      newVertex.boneIndices[3] = oldVertex.BoneIndices[3];
-
-      v.push_back(newVertex);
-    }
-
-    return v;
-  }
-
-  Vector3 transformToBindPose(const ZenLoad::SkeletalVertex& vertex)
-  {
-    Vector3 transformed = Vector3(0.0f, 0.0f, 0.0f);
-
-    for (size_t i = 0; i < 4; i++)
-    {
-      Vector3 localPosition = Vector3(vertex.LocalPositions[i].x, vertex.LocalPositions[i].y,
-                                      vertex.LocalPositions[i].z);
-
-      Vector4 tmp = mBindPose[vertex.BoneIndices[i]].multiply(Vector4(localPosition, 1.0f));
-      transformed += Vector3(tmp) * vertex.Weights[i];
-    }
-
-    return transformed;
-  }
-
   MESH_DESC meshDescForPackedMesh()
   {
     MESH_DESC desc = {};
@@ -241,65 +342,15 @@ private:
       desc.numIndices += (UINT32)submesh.indices.size();
     }
 
-    desc.indexType = IndexType::IT_32BIT;
     desc.numVertices = (UINT32)mPackedMesh.vertices.size();
+    desc.indexType = ChooseIndexType(desc.numVertices);
 
-    desc.vertexDesc = makeVertexDataDescForZenLibVertex();
+    desc.vertexDesc = makeVertexDataDescForSkeletalVertex();
     desc.usage = MU_CPUCACHED;  // To create our physics mesh later
 
     return desc;
   }
 
-  SPtr<VertexDataDesc> makeVertexDataDescForZenLibVertex()
-  {
-    SPtr<VertexDataDesc> vertexDataDesc = VertexDataDesc::create();
-    vertexDataDesc->addVertElem(VET_FLOAT3, VES_POSITION);
-    vertexDataDesc->addVertElem(VET_FLOAT3, VES_NORMAL);
-    vertexDataDesc->addVertElem(VET_FLOAT2, VES_TEXCOORD);
-    vertexDataDesc->addVertElem(VET_COLOR, VES_COLOR);
-    vertexDataDesc->addVertElem(VET_FLOAT3, VES_TANGENT);
-    vertexDataDesc->addVertElem(VET_FLOAT3, VES_BITANGENT);
-    vertexDataDesc->addVertElem(VET_UBYTE4, VES_BLEND_INDICES);
-    vertexDataDesc->addVertElem(VET_FLOAT4, VES_BLEND_WEIGHTS);
-    // vertexDataDesc->addVertElem(VET_UBYTE4, VES_TEXCOORD, 1);
-    // vertexDataDesc->addVertElem(VET_FLOAT4, VES_TEXCOORD, 2);
-
-    assert(vertexDataDesc->getVertexStride() == sizeof(SkeletalVertex));
-
-    return vertexDataDesc;
-  }
-
-  void fillMeshDataFromPackedMesh(HMesh target, const Vector<SkeletalVertex>& vertices)
-  {
-    // Allocate a buffer big enough to hold what we specified in the MESH_DESC
-    SPtr<MeshData> meshData = target->allocBuffer();
-
-    transferVertices(meshData, vertices);
-    transferIndices(meshData);
-
-    target->writeData(meshData, false);
-  }
-
-  void transferVertices(SPtr<MeshData> target, const Vector<SkeletalVertex>& vertices)
-  {
-    assert(target->getNumVertices() == vertices.size());
-
-    UINT8* pVertices = target->getElementData(VES_POSITION);
-    memcpy(pVertices, vertices.data(), sizeof(SkeletalVertex) * vertices.size());
-  }
-
-  void transferIndices(SPtr<MeshData> target)
-  {
-    UINT32* pIndices = target->getIndices32();
-    size_t writtenSoFar = 0;
-
-    for (const auto& submesh : mPackedMesh.subMeshes)
-    {
-      memcpy(&pIndices[writtenSoFar], submesh.indices.data(),
-             sizeof(UINT32) * submesh.indices.size());
-      writtenSoFar += submesh.indices.size();
-    }
-  }
   SPtr<Skeleton> mSkeleton;
   Vector<Matrix4> mBindPose;
   String mMdlFile;
@@ -454,14 +505,20 @@ public:
 
     if (!loadModelScript())
     {
-      BS_EXCEPT(InternalErrorException, "Could not load model script: " + modelScriptFile);
+      BS_LOG(Error, Uncategorized,
+             "[SkeletalMesh] Could not load model script: " + modelScriptFile);
+      return;
     }
 
     if (!mMeshHierarchy.loadHierarchy())
     {
-      BS_EXCEPT(InternalErrorException, "Could not load model hierarchy: " + getHierarchyFile());
+      BS_LOG(Error, Uncategorized,
+             "[SkeletalMesh] Could not load model hierarchy: " + getHierarchyFile());
+      return;
     }
 
+    mIsValid = true;
+
     mMeshHierarchy.makeBindPose();
     mMeshHierarchy.makeSkeleton();
 
@@ -471,43 +528,78 @@ public:
 
       if (!meshFile.empty())
       {
-        SkeletonImporter skeleton(meshFile, mVDFS);
+        // Meshes like HUM_BODY_NAKED0.MDM are used by many model scripts, which might be
+        // imported at the same time or have been cached by another one before
+        Path path = GothicPathToCachedSkeletalMesh(meshFile);
 
-        if (skeleton.loadHierarchy())
-        {
-          skeleton.makeBindPose();
-          skeleton.makeSkeleton();
-        }
+        HMeshWithMaterials imported = ImportOnce<MeshWithMaterials>(path, [&]() {
+          CacheSourceStamp stamp;
+          bool hasStamp =
+              MakeCacheSourceStamp(meshFile, mVDFS, GetSkeletalMeshImporterVersion(), stamp);
 
-        HMeshWithMaterials imported;
+          if (hasStamp && HasCachedResource(path, stamp))
+          {
+            return LoadCachedResource<MeshWithMaterials>(path);
+          }
 
-        // The meshfile might come with it's own skeleton, so we have to use that to not get weirdly
-        // broken models. For example, the basic HUM_BODY_NAKED0.MDM uses a general skeleton and
-        // does not have a matching .MDL file containing both mesh and skeleton.
-        // However, most Armors come as .MDL file, which also contains a skeleton. Hence, we try
-        // to use that and fall back to the generic one.
-        if (skeleton.mSkeleton != nullptr)
-        {
-          SkeletalMeshGeometryLoader loader(meshFile, skeleton.mBindPose, skeleton.mSkeleton, mVDFS);
+          HMeshWithMaterials combined;
 
-          imported = MeshWithMaterials::create(
-              loader.getImportedMesh(), loader.getImportedMaterials(), loader.getNodeAttachments());
-        }
-        else
-        {
-          SkeletalMeshGeometryLoader loader(meshFile, mMeshHierarchy.mBindPose,
-                                            mMeshHierarchy.mSkeleton, mVDFS);
+          SkeletonImporter skeleton(meshFile, mVDFS);
 
-          imported = MeshWithMaterials::create(
-              loader.getImportedMesh(), loader.getImportedMaterials(), loader.getNodeAttachments());
-        }
+          if (skeleton.loadHierarchy())
+          {
+            skeleton.makeBindPose();
+            skeleton.makeSkeleton();
+          }
+
+          // The meshfile might come with it's own skeleton, so we have to use that to not get
+          // weirdly broken models. For example, the basic HUM_BODY_NAKED0.MDM uses a general
+          // skeleton and does not have a matching .MDL file containing both mesh and skeleton.
+          // However, most Armors come as .MDL file, which also contains a skeleton. Hence, we
+          // try to use that and fall back to the generic one.
+          if (skeleton.mSkeleton != nullptr)
+          {
+            SkeletalMeshGeometryLoader loader(meshFile, skeleton.mBindPose, skeleton.mSkeleton,
+                                              mVDFS);
+
+            if (!loader.isValid()) return combined;
+
+            combined = MeshWithMaterials::create(loader.getImportedMesh(),
+                                                 loader.getImportedMaterials(),
+                                                 loader.getNodeAttachments());
+          }
+          else
+          {
+            SkeletalMeshGeometryLoader loader(meshFile, mMeshHierarchy.mBindPose,
+                                              mMeshHierarchy.mSkeleton, mVDFS);
+
+            if (!loader.isValid()) return combined;
+
+            combined = MeshWithMaterials::create(loader.getImportedMesh(),
+                                                 loader.getImportedMaterials(),
+                                                 loader.getNodeAttachments());
+          }
+
+          if (combined)
+          {
+            const bool overwrite = true;
+            gResources().save(combined, path, overwrite);
+
+            if (hasStamp)
+            {
+              AddToResourceManifest(combined, path, stamp);
+            }
+            else
+            {
+              AddToResourceManifest(combined, path);
+            }
+          }
+
+          return combined;
+        });
 
         if (imported)
         {
-          const bool overwrite = true;
-          gResources().save(imported, GothicPathToCachedSkeletalMesh(meshFile), overwrite);
-          AddToResourceManifest(imported, GothicPathToCachedSkeletalMesh(meshFile));
-
           mMeshes.push_back(imported);
         }
         else
@@ -528,16 +620,19 @@ public:
 
     for (const auto& ani : mAnimationsToImport)
     {
-      HZAnimation animation;
+      // Overlays share animations with the model script they are based on
+      Path path = GothicPathToCachedZAnimation(ani.fullAnimationName);
 
-      if (HasCachedMAN(ani.fullAnimationName))
-      {
-        animation = LoadCachedAnimation(ani.fullAnimationName);
-      }
-      else
-      {
-        animation = ImportMAN(mMeshHierarchy.mMeshHierarchy, ani, mVDFS);
-      }
+      HZAnimation animation = ImportOnce<ZAnimationClip>(path, [&]() {
+        if (HasCachedMAN(ani.fullAnimationName))
+        {
+          return LoadCachedAnimation(ani.fullAnimationName);
+        }
+        else
+        {
+          return ImportMAN(mMeshHierarchy.mMeshHierarchy, ani, mVDFS);
+        }
+      });
 
       if (animation)
       {
@@ -599,6 +694,12 @@ public:
     }
   }
 
+  /**
+   * @return Whether model script and hierarchy could be loaded. If not, the reason has been
+   *         logged already.
+   */
+  bool isValid() const { return mIsValid; }
+
   Vector<HMeshWithMaterials> getMeshes() const { return mMeshes; }
 
   Vector<HZAnimation> getAnimations() const { return mAnimations; }
@@ -676,7 +777,9 @@ private:
     }
     else
     {
-      BS_EXCEPT(InternalErrorException, "Could not determine file type of " + mModelScriptFile);
+      BS_LOG(Error, Uncategorized,
+             "[SkeletalMesh] Could not determine file type of " + mModelScriptFile);
+      return false;
     }
 
     ModelScriptParser& p = *mModelScriptParser;
@@ -830,6 +933,7 @@ private:
   Vector<HMeshWithMaterials> mMeshes;
   const VDFS::FileIndex& mVDFS;
   SkeletonImporter mMeshHierarchy;
+  bool mIsValid = false;
 
   SPtr<ZenLoad::ModelScriptParser> mModelScriptParser;
 };
@@ -852,7 +956,8 @@ public:
   {
     if (!mMeshHierarchy.loadHierarchy())
     {
-      BS_EXCEPT(InternalErrorException, "Could not load model hierarchy: " + modelFile);
+      BS_LOG(Error, Uncategorized, "[SkeletalMesh] Could not load model hierarchy: " + modelFile);
+      return;
     }
 
     mMeshHierarchy.makeBindPose();
@@ -861,6 +966,9 @@ public:
     SkeletalMeshGeometryLoader loader(modelFile, mMeshHierarchy.mBindPose, mMeshHierarchy.mSkeleton,
                                       mVDFS);
 
+    // Without its mesh, there is nothing left of the model
+    if (!loader.isValid()) return;
+
     HMeshWithMaterials imported = MeshWithMaterials::create(
         loader.getImportedMesh(), loader.getImportedMaterials(), loader.getNodeAttachments());
 
@@ -878,6 +986,11 @@ public:
     }
   }
 
+  /**
+   * @return Whether the model could be loaded. If not, the reason has been logged already.
+   */
+  bool isValid() const { return !mMeshes.empty(); }
+
   Vector<HMeshWithMaterials> getMeshes() const { return mMeshes; }
 
   /**
@@ -893,9 +1006,11 @@ private:
   bs::String mModelFile;
 };
 
-HModelScriptFile BsZenLib::ImportAndCacheMDS(const bs::String& mdsFile, const VDFS::FileIndex& vdfs)
+/**
+ * Resolves which kind of model file to load. .ASC-files are loaded from their .MDL-file.
+ */
+static bs::String modelSourceFile(const bs::String& mdsFile)
 {
-  HModelScriptFile mds;
   bs::String actualFileName = mdsFile;
 
   // Might got the uncompiled filename as input (Only for MDL-loading)
@@ -904,10 +1019,39 @@ HModelScriptFile BsZenLib::ImportAndCacheMDS(const bs::String& mdsFile, const VD
     actualFileName = stripExtension(mdsFile) + ".MDL";
   }
 
+  return actualFileName;
+}
+
+/**
+ * Builds the cache stamp of a model from the file it is actually loaded from. For model
+ * scripts, that is the .MSB-file if there is one.
+ */
+static bool modelSourceStamp(const bs::String& mdsFile, const VDFS::FileIndex& vdfs,
+                             CacheSourceStamp& outStamp)
+{
+  bs::String sourceFile = modelSourceFile(mdsFile);
+
+  if (sourceFile.find(".MDS") != bs::String::npos)
+  {
+    bs::String msb = stripExtension(sourceFile) + ".MSB";
+
+    if (vdfs.hasFile(msb.c_str())) sourceFile = msb;
+  }
+
+  return MakeCacheSourceStamp(sourceFile, vdfs, GetSkeletalMeshImporterVersion(), outStamp);
+}
+
+static HModelScriptFile importAndCacheMDS(const bs::String& mdsFile, const VDFS::FileIndex& vdfs)
+{
+  HModelScriptFile mds;
+  bs::String actualFileName = modelSourceFile(mdsFile);
+
   if (actualFileName.find(".MDS") != bs::String::npos)
   {
     ModelScriptFileImporter importer(actualFileName, vdfs);
 
+    if (!importer.isValid()) return {};
+
     mds = ModelScriptFile::create(importer.getMeshes(), importer.getAnimations());
 
     mds->setName(importer.getModelScriptName());
@@ -916,30 +1060,71 @@ HModelScriptFile BsZenLib::ImportAndCacheMDS(const bs::String& mdsFile, const VD
   {
     ModelFileImporter importer(actualFileName, vdfs);
 
+    if (!importer.isValid()) return {};
+
     mds = ModelScriptFile::create(importer.getMeshes(), {});
 
     mds->setName(importer.getModelName());
   }
   else
   {
-    BS_EXCEPT(InternalErrorException, "Unsupported Model File:" + mdsFile);
+    BS_LOG(Error, Uncategorized, "[SkeletalMesh] Unsupported Model File: " + mdsFile);
+    return {};
   }
 
+  ScopedImportTimer timer("ModelScript", "Save", mdsFile);
+
   const bool overwrite = true;
   gResources().save(mds, GothicPathToCachedModelScript(mdsFile), overwrite);
-  AddToResourceManifest(mds, GothicPathToCachedModelScript(mdsFile));
+
+  timer.setBytesOutFromFile(GothicPathToCachedModelScript(mdsFile));
+
+  CacheSourceStamp stamp;
+  if (modelSourceStamp(mdsFile, vdfs, stamp))
+  {
+    AddToResourceManifest(mds, GothicPathToCachedModelScript(mdsFile), stamp);
+  }
+  else
+  {
+    AddToResourceManifest(mds, GothicPathToCachedModelScript(mdsFile));
+  }
 
   return mds;
 }
 
+UINT32 BsZenLib::GetSkeletalMeshImporterVersion()
+{
+  UINT32 settings = IsTextureStreamingEnabled() ? 1 : 0;
+
+  return SKELETAL_MESH_IMPORTER_VERSION + (settings << 16);
+}
+
+HModelScriptFile BsZenLib::ImportAndCacheMDS(const bs::String& mdsFile, const VDFS::FileIndex& vdfs)
+{
+  return ImportOnce<ModelScriptFile>(GothicPathToCachedModelScript(mdsFile),
+                                     [&]() { return importAndCacheMDS(mdsFile, vdfs); });
+}
+
 bool BsZenLib::HasCachedMDS(const bs::String& mdsFile)
 {
   return HasCachedResource(GothicPathToCachedModelScript(mdsFile));
 }
 
+bool BsZenLib::HasCachedMDS(const bs::String& mdsFile, const VDFS::FileIndex& vdfs)
+{
+  CacheSourceStamp stamp;
+
+  if (!modelSourceStamp(mdsFile, vdfs, stamp))
+  {
+    return HasCachedMDS(mdsFile);
+  }
+
+  return HasCachedResource(GothicPathToCachedModelScript(mdsFile), stamp);
+}
+
 HModelScriptFile BsZenLib::LoadCachedMDS(const bs::String& mdsFile)
 {
-  return gResources().load<ModelScriptFile>(GothicPathToCachedModelScript(mdsFile));
+  return LoadCachedResource<ModelScriptFile>(GothicPathToCachedModelScript(mdsFile));
 }
 
 bs::Map<bs::String, HMeshWithMaterials> BsZenLib::ImportAndCacheNodeAttachments(
@@ -959,14 +1144,18 @@ bs::Map<bs::String, HMeshWithMaterials> BsZenLib::ImportAndCacheNodeAttachments(
     String cacheName = mdlFile + "-attach-" + a.first.c_str();
     String attachTo = a.first.c_str();
 
-    if (HasCachedStaticMesh(cacheName))
-    {
-      attachments[attachTo] = LoadCachedStaticMesh(cacheName);
-    }
-    else
-    {
-      attachments[attachTo] = ImportAndCacheStaticMesh(cacheName, packed, vdfs);
-    }
+    Path path = GothicPathToCachedStaticMesh(cacheName);
+
+    attachments[attachTo] = ImportOnce<MeshWithMaterials>(path, [&]() {
+      if (HasCachedStaticMesh(cacheName))
+      {
+        return LoadCachedStaticMesh(cacheName);
+      }
+      else
+      {
+        return ImportAndCacheStaticMesh(cacheName, packed, vdfs);
+      }
+    });
   }
 
   return attachments;
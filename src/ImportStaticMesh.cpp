@@ -1,7 +1,17 @@
 #include "ImportStaticMesh.hpp"
+#include "CachePack.hpp"
 #include "ImportMaterial.hpp"
+#include "ImportMetrics.hpp"
 #include "ImportPath.hpp"
+#include "InFlightImports.hpp"
+#include "MeshIndices.hpp"
+#include "MeshOptimization.hpp"
+#include "MeshTangents.hpp"
 #include "ResourceManifest.hpp"
+#include "ScratchBuffer.hpp"
+#include "TextureStreaming.hpp"
+#include <algorithm>
+#include <atomic>
 #include <Components/BsCRenderable.h>
 #include <FileSystem/BsFileSystem.h>
 #include <RenderAPI/BsVertexDataDesc.h>
@@ -15,24 +25,90 @@
 
 using namespace bs;
 
-struct StaticMeshVertex
+/**
+ * A single attribute of a cached vertex.
+ */
+struct VertexAttribute
 {
-  Vector3 position;
-  Vector3 normal;
-  Vector2 texCoord;
-  uint32_t color;
-  Vector3 tangent;
-  Vector3 bitangent;
+  VertexElementSemantic semantic;
+  VertexElementType type;
 };
 
+/**
+ * Attributes of a vertex format, in the order they are stored inside a vertex.
+ */
+struct VertexFormatDesc
+{
+  const VertexAttribute* attributes;
+  UINT32 numAttributes;
+};
+
+/**
+ * The tangent is always there so existing shaders still find it, but only filled in for meshes
+ * with normal mapped materials. Its handedness in `w` replaces a separate bitangent.
+ */
+static const VertexAttribute FULL_VERTEX_ATTRIBUTES[] = {
+    {VES_POSITION, VET_FLOAT3},  //
+    {VES_NORMAL, VET_FLOAT3},    //
+    {VES_TEXCOORD, VET_FLOAT2},  //
+    {VES_COLOR, VET_COLOR},      //
+    {VES_TANGENT, VET_FLOAT4},
+};
+
+/**
+ * Positions stay full floats, as bounds and physics meshes are computed from them. Normals are
+ * packed the same way bs::f packs them for its own meshes.
+ */
+static const VertexAttribute COMPACT_VERTEX_ATTRIBUTES[] = {
+    {VES_POSITION, VET_FLOAT3},     //
+    {VES_NORMAL, VET_UBYTE4_NORM},  //
+    {VES_TEXCOORD, VET_FLOAT2},     //
+    {VES_COLOR, VET_COLOR},
+};
+
+/**
+ * Tangents are packed like the normals, with the handedness going from 0 to 255.
+ */
+static const VertexAttribute COMPACT_TANGENT_VERTEX_ATTRIBUTES[] = {
+    {VES_POSITION, VET_FLOAT3},     //
+    {VES_NORMAL, VET_UBYTE4_NORM},  //
+    {VES_TEXCOORD, VET_FLOAT2},     //
+    {VES_COLOR, VET_COLOR},         //
+    {VES_TANGENT, VET_UBYTE4_NORM},
+};
+
+template <size_t N>
+static constexpr UINT32 numAttributes(const VertexAttribute (&)[N])
+{
+  return (UINT32)N;
+}
+
+static std::atomic<BsZenLib::StaticMeshVertexFormat> s_VertexFormat{
+    BsZenLib::StaticMeshVertexFormat::Full};
+static std::atomic<bool> s_IsOptimizationEnabled{false};
+
+static String compiledMeshName(const String& originalFileName);
+static BsZenLib::Res::HMeshWithMaterials combineAndCacheStaticMesh(
+    const bs::String& originalFileName, const ZenLoad::PackedMesh& packedMesh,
+    const Vector<HMaterial>& materials);
 static HPrefab cacheStaticMesh(const bs::String& originalFileName, HMesh mesh,
                                const Vector<HMaterial>& materials);
-static SPtr<VertexDataDesc> makeVertexDataDescForZenLibVertex();
-static MESH_DESC meshDescForPackedMesh(const ZenLoad::PackedMesh& packedMesh);
-static Vector<StaticMeshVertex> transformVertices(const ZenLoad::PackedMesh& packedMesh);
-static void fillMeshDataFromPackedMesh(HMesh target, const Vector<StaticMeshVertex>& vertices,
-                                       const ZenLoad::PackedMesh& packedMesh);
-static void transferVertices(SPtr<MeshData> target, const Vector<StaticMeshVertex>& vertices);
+static bool anyMaterialNeedsTangents(const Vector<HMaterial>& materials);
+static VertexFormatDesc describeVertexFormat(BsZenLib::StaticMeshVertexFormat format,
+                                             bool withTangents);
+static SPtr<VertexDataDesc> makeVertexDataDescForZenLibVertex(const VertexFormatDesc& format);
+static HMesh importStaticMeshGeometry(const String& name, const ZenLoad::PackedMesh& packedMesh,
+                                      bool withTangents);
+static void optimizeMesh(const String& name, ZenLoad::PackedMesh& packedMesh);
+static MESH_DESC meshDescForPackedMesh(const ZenLoad::PackedMesh& packedMesh,
+                                       const VertexFormatDesc& format);
+static void transferVertices(SPtr<MeshData> target, const VertexFormatDesc& format,
+                             const ZenLoad::PackedMesh& packedMesh,
+                             const Vector<Vector4>& tangents);
+static void writeVertexAttribute(const VertexAttribute& attribute,
+                                 const ZenLoad::PackedMesh& packedMesh,
+                                 const Vector<Vector4>& tangents, UINT8* dst, UINT32 stride);
+static UINT32 packNormal(float x, float y, float z);
 static void transferIndices(SPtr<MeshData> target, const ZenLoad::PackedMesh& packedMesh);
 
 // - Implementation --------------------------------------------------------------------------------
@@ -40,46 +116,100 @@ static void transferIndices(SPtr<MeshData> target, const ZenLoad::PackedMesh& pa
 BsZenLib::Res::HMeshWithMaterials BsZenLib::ImportAndCacheStaticMesh(
     const bs::String& originalFileName, const VDFS::FileIndex& vdfs)
 {
-  BS_LOG(Info, Uncategorized, "Caching Static Mesh: " + originalFileName);
+  Path path = GothicPathToCachedStaticMesh(originalFileName);
 
-  HMesh mesh = ImportAndCacheStaticMeshGeometry(originalFileName, vdfs);
+  return ImportOnce<Res::MeshWithMaterials>(path, [&]() -> Res::HMeshWithMaterials {
+    BS_LOG(Info, Uncategorized, "Caching Static Mesh: " + originalFileName);
 
-  if (!mesh)
-  {
-    BS_LOG(Warning, Uncategorized, "Load Failed (Mesh): " + originalFileName);
-    return {};
-  }
+    CacheSourceStamp stamp;
+    bool hasSource;
+    {
+      ScopedImportTimer timer("StaticMesh", "Hash", originalFileName);
+      hasSource = MakeCacheSourceStamp(compiledMeshName(originalFileName), vdfs,
+                                       GetStaticMeshImporterVersion(), stamp);
+    }
+
+    if (!hasSource)
+    {
+      BS_LOG(Warning, Uncategorized, "Load Failed (Mesh): " + originalFileName);
+      return {};
+    }
 
-  Vector<HMaterial> materials = ImportAndCacheStaticMeshMaterials(originalFileName, vdfs);
+    ZenLoad::PackedMesh packedMesh;
+    {
+      ScopedImportTimer timer("StaticMesh", "Parse", originalFileName);
 
-  if (materials.empty())
-  {
-    BS_LOG(Warning, Uncategorized, "Load Failed (Materials): " + originalFileName);
-    return {};
-  }
+      ZenLoad::zCProgMeshProto progMesh(compiledMeshName(originalFileName).c_str(), vdfs);
 
-  Res::HMeshWithMaterials combined = Res::MeshWithMaterials::create(mesh, materials);
+      if (progMesh.getNumSubmeshes() == 0)
+      {
+        BS_LOG(Warning, Uncategorized, "Load Failed (Mesh): " + originalFileName);
+        return {};
+      }
 
-  if (!combined)
-  {
-    BS_LOG(Warning, Uncategorized, "Load Failed (Combined): " + originalFileName);
-    return {};
-  }
+      progMesh.packMesh(packedMesh, 0.01f);
+    }
 
-  const bool overwrite = true;
-  gResources().save(combined, GothicPathToCachedStaticMesh(originalFileName), overwrite);
-  AddToResourceManifest(combined, GothicPathToCachedStaticMesh(originalFileName));
+    Vector<HMaterial> materials =
+        ImportAndCacheStaticMeshMaterials(originalFileName, packedMesh, vdfs);
 
-  return combined;
+    return ImportAndCacheStaticMesh(originalFileName, packedMesh, materials, stamp);
+  });
 }
 
 BsZenLib::Res::HMeshWithMaterials BsZenLib::ImportAndCacheStaticMesh(
     const bs::String& originalFileName, const ZenLoad::PackedMesh& packedMesh,
     const VDFS::FileIndex& vdfs)
 {
-  BS_LOG(Info, Uncategorized, "Caching Static Mesh: " + originalFileName);
+  Path path = GothicPathToCachedStaticMesh(originalFileName);
+
+  return ImportOnce<Res::MeshWithMaterials>(path, [&]() -> Res::HMeshWithMaterials {
+    BS_LOG(Info, Uncategorized, "Caching Static Mesh: " + originalFileName);
+
+    Vector<HMaterial> materials =
+        ImportAndCacheStaticMeshMaterials(originalFileName, packedMesh, vdfs);
+
+    Res::HMeshWithMaterials combined =
+        combineAndCacheStaticMesh(originalFileName, packedMesh, materials);
+
+    if (!combined) return {};
+
+    AddToResourceManifest(combined, path);
+
+    return combined;
+  });
+}
+
+BsZenLib::Res::HMeshWithMaterials BsZenLib::ImportAndCacheStaticMesh(
+    const bs::String& originalFileName, const ZenLoad::PackedMesh& packedMesh,
+    const bs::Vector<bs::HMaterial>& materials, const CacheSourceStamp& stamp)
+{
+  Path path = GothicPathToCachedStaticMesh(originalFileName);
+
+  return ImportOnce<Res::MeshWithMaterials>(path, [&]() -> Res::HMeshWithMaterials {
+    Res::HMeshWithMaterials combined =
+        combineAndCacheStaticMesh(originalFileName, packedMesh, materials);
+
+    if (!combined) return {};
+
+    AddToResourceManifest(combined, path, stamp);
+
+    return combined;
+  });
+}
+
+/**
+ * Imports the geometry of the given mesh and saves it together with the already imported
+ * materials. Does not register the combined resource inside the manifest.
+ */
+static BsZenLib::Res::HMeshWithMaterials combineAndCacheStaticMesh(
+    const bs::String& originalFileName, const ZenLoad::PackedMesh& packedMesh,
+    const Vector<HMaterial>& materials)
+{
+  using namespace BsZenLib;
 
-  HMesh mesh = ImportAndCacheStaticMeshGeometry(originalFileName, packedMesh);
+  HMesh mesh = ImportAndCacheStaticMeshGeometry(originalFileName, packedMesh,
+                                                anyMaterialNeedsTangents(materials));
 
   if (!mesh)
   {
@@ -87,10 +217,12 @@ BsZenLib::Res::HMeshWithMaterials BsZenLib::ImportAndCacheStaticMesh(
     return {};
   }
 
-  Vector<HMaterial> materials =
-      ImportAndCacheStaticMeshMaterials(originalFileName, packedMesh, vdfs);
+  // A material which failed to import leaves an empty handle behind. Caching the mesh anyways
+  // would render that submesh without a material until the mesh is imported again.
+  bool isAnyMaterialMissing =
+      std::any_of(materials.begin(), materials.end(), [](const HMaterial& m) { return !m; });
 
-  if (materials.empty())
+  if (materials.empty() || isAnyMaterialMissing)
   {
     BS_LOG(Warning, Uncategorized, "Load Failed (Materials): " + originalFileName);
     return {};
@@ -104,28 +236,46 @@ BsZenLib::Res::HMeshWithMaterials BsZenLib::ImportAndCacheStaticMesh(
     return {};
   }
 
+  ScopedImportTimer timer("StaticMesh", "Save", originalFileName);
+
   const bool overwrite = true;
   gResources().save(combined, GothicPathToCachedStaticMesh(originalFileName), overwrite);
-  AddToResourceManifest(combined, GothicPathToCachedStaticMesh(originalFileName));
+
+  timer.setBytesOutFromFile(GothicPathToCachedStaticMesh(originalFileName));
 
   return combined;
 }
 
 BsZenLib::Res::HMeshWithMaterials BsZenLib::LoadCachedStaticMesh(const bs::String& originalFileName)
 {
-  return gResources().load<Res::MeshWithMaterials>(GothicPathToCachedStaticMesh(originalFileName));
+  return LoadCachedResource<Res::MeshWithMaterials>(GothicPathToCachedStaticMesh(originalFileName));
 }
 
 bool BsZenLib::HasCachedStaticMesh(const bs::String& originalFileName)
 {
-  return FileSystem::isFile(GothicPathToCachedStaticMesh(originalFileName));
+  Path path = GothicPathToCachedStaticMesh(originalFileName);
+
+  return HasPackedResource(path) || FileSystem::isFile(path);
+}
+
+bool BsZenLib::HasCachedStaticMesh(const bs::String& originalFileName,
+                                   const VDFS::FileIndex& vdfs)
+{
+  CacheSourceStamp stamp;
+
+  if (!MakeCacheSourceStamp(compiledMeshName(originalFileName), vdfs,
+                            GetStaticMeshImporterVersion(), stamp))
+  {
+    return HasCachedStaticMesh(originalFileName);
+  }
+
+  return HasCachedResource(GothicPathToCachedStaticMesh(originalFileName), stamp);
 }
 
 HMesh BsZenLib::ImportAndCacheStaticMeshGeometry(const bs::String& originalFileName,
                                                  const VDFS::FileIndex& vdfs)
 {
-  bs::String withoutExt = originalFileName.substr(0, originalFileName.find_last_of('.'));
-  bs::String compiledExt = withoutExt + ".MRM";
+  bs::String compiledExt = compiledMeshName(originalFileName);
 
   ZenLoad::zCProgMeshProto progMesh(compiledExt.c_str(), vdfs);
 
@@ -138,27 +288,37 @@ HMesh BsZenLib::ImportAndCacheStaticMeshGeometry(const bs::String& originalFileN
 }
 
 bs::HMesh BsZenLib::ImportAndCacheStaticMeshGeometry(const bs::String& originalFileName,
-                                                     const ZenLoad::PackedMesh& packedMesh)
+                                                     const ZenLoad::PackedMesh& packedMesh,
+                                                     bool withTangents)
 {
-  HMesh mesh = ImportStaticMeshGeometry(packedMesh);
   Path path = GothicPathToCachedStaticMesh(originalFileName + ".mesh");
 
-  if (!mesh) return {};
+  return ImportOnce<Mesh>(path, [&]() -> HMesh {
+    HMesh mesh = importStaticMeshGeometry(originalFileName, packedMesh, withTangents);
 
-  mesh->setName(originalFileName);
+    if (!mesh) return {};
 
-  const bool overwrite = true;
-  gResources().save(mesh, path, overwrite);
-  AddToResourceManifest(mesh, path);
+    mesh->setName(originalFileName);
 
-  return mesh;
+    {
+      ScopedImportTimer timer("StaticMesh", "SaveGeometry", originalFileName);
+
+      const bool overwrite = true;
+      gResources().save(mesh, path, overwrite);
+
+      timer.setBytesOutFromFile(path);
+    }
+
+    AddToResourceManifest(mesh, path);
+
+    return mesh;
+  });
 }
 
 Vector<HMaterial> BsZenLib::ImportAndCacheStaticMeshMaterials(const bs::String& originalFileName,
                                                               const VDFS::FileIndex& vdfs)
 {
-  bs::String withoutExt = originalFileName.substr(0, originalFileName.find_last_of('.'));
-  bs::String compiledExt = withoutExt + ".MRM";
+  bs::String compiledExt = compiledMeshName(originalFileName);
 
   ZenLoad::zCProgMeshProto progMesh(compiledExt.c_str(), vdfs);
 
@@ -182,17 +342,11 @@ Vector<HMaterial> BsZenLib::ImportAndCacheStaticMeshMaterials(const bs::String&
     // TODO: Transfer more properties
     const auto& originalMaterial = packedMesh.subMeshes[i].material;
 
-    HMaterial loaded;
     String materialCacheFile = BuildMaterialNameForSubmesh(originalFileName, (UINT32)i);
 
-    if (HasCachedMaterial(materialCacheFile))
-    {
-      loaded = LoadCachedMaterial(materialCacheFile);
-    }
-    else
-    {
-      loaded = ImportAndCacheMaterialWithTextures(materialCacheFile, originalMaterial, vdfs);
-    }
+    // Always import, the cached material might have been built from an outdated mesh
+    HMaterial loaded =
+        ImportAndCacheMaterialWithTextures(materialCacheFile, originalMaterial, vdfs);
 
     materials.push_back(loaded);
   }
@@ -200,19 +354,124 @@ Vector<HMaterial> BsZenLib::ImportAndCacheStaticMeshMaterials(const bs::String&
   return materials;
 }
 
-HMesh BsZenLib::ImportStaticMeshGeometry(const ZenLoad::PackedMesh& packedMesh)
+void BsZenLib::SetStaticMeshVertexFormat(StaticMeshVertexFormat format)
+{
+  s_VertexFormat = format;
+}
+
+BsZenLib::StaticMeshVertexFormat BsZenLib::GetStaticMeshVertexFormat()
+{
+  return s_VertexFormat.load();
+}
+
+void BsZenLib::SetStaticMeshOptimization(bool enabled)
+{
+  s_IsOptimizationEnabled = enabled;
+}
+
+bool BsZenLib::GetStaticMeshOptimization()
 {
-  MESH_DESC desc = meshDescForPackedMesh(packedMesh);
+  return s_IsOptimizationEnabled.load();
+}
+
+UINT32 BsZenLib::GetStaticMeshImporterVersion()
+{
+  // Materials are cached along with the mesh, so they follow texture streaming as well
+  UINT32 settings = (UINT32)s_VertexFormat.load() | (s_IsOptimizationEnabled.load() ? 2 : 0) |
+                    (IsTextureStreamingEnabled() ? 4 : 0);
+
+  return STATIC_MESH_IMPORTER_VERSION + (settings << 16);
+}
+
+HMesh BsZenLib::ImportStaticMeshGeometry(const ZenLoad::PackedMesh& packedMesh, bool withTangents)
+{
+  return importStaticMeshGeometry("", packedMesh, withTangents);
+}
+
+/**
+ * Like ImportStaticMeshGeometry(), the name is only used for recording metrics.
+ */
+static HMesh importStaticMeshGeometry(const String& name, const ZenLoad::PackedMesh& original,
+                                      bool withTangents)
+{
+  using namespace BsZenLib;
+
+  // Optimizing reorders the mesh, so it needs a copy to work on
+  const bool optimize = s_IsOptimizationEnabled.load();
+  ZenLoad::PackedMesh optimized;
+
+  if (optimize)
+  {
+    optimized = original;
+    optimizeMesh(name, optimized);
+  }
+
+  const ZenLoad::PackedMesh& packedMesh = optimize ? optimized : original;
+
+  VertexFormatDesc format = describeVertexFormat(s_VertexFormat.load(), withTangents);
+  MESH_DESC desc = meshDescForPackedMesh(packedMesh, format);
 
   HMesh mesh = Mesh::create(desc);
 
-  Vector<StaticMeshVertex> vertices = transformVertices(packedMesh);
-  fillMeshDataFromPackedMesh(mesh, vertices, packedMesh);
+  // Allocate a buffer big enough to hold what we specified in the MESH_DESC
+  SPtr<MeshData> meshData = mesh->allocBuffer();
+
+  // Stays empty without tangents, which zeroes the tangent slot of the full format
+  ScratchBuffer<Vector<Vector4>> tangents;
+
+  if (withTangents)
+  {
+    ScopedImportTimer timer("StaticMesh", "GenerateTangents", name);
+    GenerateTangents(packedMesh, *tangents);
+
+    timer.setBytesIn(packedMesh.vertices.size() * sizeof(ZenLoad::WorldVertex));
+    timer.setBytesOut(tangents->size() * sizeof(Vector4));
+  }
+
+  {
+    ScopedImportTimer timer("StaticMesh", "TransformVertices", name);
+    transferVertices(meshData, format, packedMesh, *tangents);
+
+    timer.setBytesIn(packedMesh.vertices.size() * sizeof(ZenLoad::WorldVertex));
+    timer.setBytesOut((UINT64)desc.numVertices * desc.vertexDesc->getVertexStride());
+  }
+
+  {
+    ScopedImportTimer timer("StaticMesh", "WriteMeshData", name);
+    transferIndices(meshData, packedMesh);
+
+    mesh->writeData(meshData, false);
+  }
 
   return mesh;
 }
 
-static MESH_DESC meshDescForPackedMesh(const ZenLoad::PackedMesh& packedMesh)
+static void optimizeMesh(const String& name, ZenLoad::PackedMesh& packedMesh)
+{
+  using namespace BsZenLib;
+
+  ScopedImportTimer timer("StaticMesh", "OptimizeMesh", name);
+
+  float acmrBefore = IsImportMetricsEnabled() ? ComputeACMR(packedMesh) : 0.0f;
+
+  OptimizeVertexCache(packedMesh);
+  OptimizeVertexFetch(packedMesh);
+
+  if (IsImportMetricsEnabled())
+  {
+    timer.setMeasure("ACMR", acmrBefore, ComputeACMR(packedMesh));
+  }
+}
+
+static String compiledMeshName(const String& originalFileName)
+{
+  bs::String withoutExt = originalFileName.substr(0, originalFileName.find_last_of('.'));
+
+  return withoutExt + ".MRM";
+}
+
+static MESH_DESC meshDescForPackedMesh(const ZenLoad::PackedMesh& packedMesh,
+                                       const VertexFormatDesc& format)
 {
   MESH_DESC desc = {};
 
@@ -226,77 +485,194 @@ static MESH_DESC meshDescForPackedMesh(const ZenLoad::PackedMesh& packedMesh)
     desc.numIndices += (UINT32)submesh.indices.size();
   }
 
-  desc.indexType = IndexType::IT_32BIT;
   desc.numVertices = (UINT32)packedMesh.vertices.size();
+  desc.indexType = BsZenLib::ChooseIndexType(desc.numVertices);
 
-  desc.vertexDesc = makeVertexDataDescForZenLibVertex();
+  desc.vertexDesc = makeVertexDataDescForZenLibVertex(format);
   desc.usage = MU_CPUCACHED;  // To create our physics mesh later
 
   return desc;
 }
 
-static SPtr<VertexDataDesc> makeVertexDataDescForZenLibVertex()
+static bool anyMaterialNeedsTangents(const Vector<HMaterial>& materials)
+{
+  for (const HMaterial& material : materials)
+  {
+    if (BsZenLib::MaterialNeedsTangents(material)) return true;
+  }
+
+  return false;
+}
+
+static VertexFormatDesc describeVertexFormat(BsZenLib::StaticMeshVertexFormat format,
+                                             bool withTangents)
+{
+  switch (format)
+  {
+    case BsZenLib::StaticMeshVertexFormat::Compact:
+      if (withTangents)
+      {
+        return {COMPACT_TANGENT_VERTEX_ATTRIBUTES,
+                numAttributes(COMPACT_TANGENT_VERTEX_ATTRIBUTES)};
+      }
+
+      return {COMPACT_VERTEX_ATTRIBUTES, numAttributes(COMPACT_VERTEX_ATTRIBUTES)};
+
+    case BsZenLib::StaticMeshVertexFormat::Full:
+    default:
+      return {FULL_VERTEX_ATTRIBUTES, numAttributes(FULL_VERTEX_ATTRIBUTES)};
+  }
+}
+
+static SPtr<VertexDataDesc> makeVertexDataDescForZenLibVertex(const VertexFormatDesc& format)
 {
   SPtr<VertexDataDesc> vertexDataDesc = VertexDataDesc::create();
-  vertexDataDesc->addVertElem(VET_FLOAT3, VES_POSITION);
-  vertexDataDesc->addVertElem(VET_FLOAT3, VES_NORMAL);
-  vertexDataDesc->addVertElem(VET_FLOAT2, VES_TEXCOORD);
-  vertexDataDesc->addVertElem(VET_COLOR, VES_COLOR);
-  vertexDataDesc->addVertElem(VET_FLOAT3, VES_TANGENT);
-  vertexDataDesc->addVertElem(VET_FLOAT3, VES_BITANGENT);
+
+  for (UINT32 i = 0; i < format.numAttributes; i++)
+  {
+    vertexDataDesc->addVertElem(format.attributes[i].type, format.attributes[i].semantic);
+  }
 
   return vertexDataDesc;
 }
 
-static void fillMeshDataFromPackedMesh(HMesh target, const Vector<StaticMeshVertex>& vertices,
-                                       const ZenLoad::PackedMesh& packedMesh)
+/**
+ * Converts the vertices from ZenLib into the given format, one attribute at a time.
+ */
+static void transferVertices(SPtr<MeshData> target, const VertexFormatDesc& format,
+                             const ZenLoad::PackedMesh& packedMesh,
+                             const Vector<Vector4>& tangents)
 {
-  // Allocate a buffer big enough to hold what we specified in the MESH_DESC
-  SPtr<MeshData> meshData = target->allocBuffer();
+  assert(target->getNumVertices() == packedMesh.vertices.size());
+
+  // All attributes are interleaved inside a single stream, starting with the position
+  UINT8* vertices = target->getElementData(VES_POSITION);
+  UINT32 stride = target->getVertexDesc()->getVertexStride();
+  UINT32 offset = 0;
 
-  transferVertices(meshData, vertices);
-  transferIndices(meshData, packedMesh);
+  for (UINT32 i = 0; i < format.numAttributes; i++)
+  {
+    writeVertexAttribute(format.attributes[i], packedMesh, tangents, vertices + offset, stride);
 
-  target->writeData(meshData, false);
+    offset += VertexElement::getTypeSize(format.attributes[i].type);
+  }
 }
 
-static Vector<StaticMeshVertex> transformVertices(const ZenLoad::PackedMesh& packedMesh)
+static void writeVertexAttribute(const VertexAttribute& attribute,
+                                 const ZenLoad::PackedMesh& packedMesh,
+                                 const Vector<Vector4>& tangents, UINT8* dst, UINT32 stride)
 {
-  Vector<StaticMeshVertex> v;
+  const auto& vertices = packedMesh.vertices;
+
+  if (vertices.empty()) return;
+
+  if (attribute.semantic == VES_TANGENT && !tangents.empty())
+  {
+    for (size_t i = 0; i < vertices.size(); i++, dst += stride)
+    {
+      const Vector4& tangent = tangents[i];
+
+      if (attribute.type == VET_UBYTE4_NORM)
+      {
+        UINT32 packed = packNormal(tangent.x, tangent.y, tangent.z);
+        packed |= (tangent.w < 0.0f ? 0u : 255u) << 24;
+
+        memcpy(dst, &packed, sizeof(packed));
+      }
+      else
+      {
+        memcpy(dst, &tangent, sizeof(tangent));
+      }
+    }
+
+    return;
+  }
 
-  for (const ZenLoad::WorldVertex& oldVertex : packedMesh.vertices)
+  if (attribute.semantic == VES_NORMAL && attribute.type == VET_UBYTE4_NORM)
   {
-    StaticMeshVertex newVertex = {};
+    for (size_t i = 0; i < vertices.size(); i++, dst += stride)
+    {
+      const auto& normal = vertices[i].Normal;
+      UINT32 packed = packNormal(normal.x, normal.y, normal.z);
+
+      memcpy(dst, &packed, sizeof(packed));
+    }
+
+    return;
+  }
+
+  // Everything else is copied as it is, or zeroed if ZenLib does not have it
+  const UINT8* src = nullptr;
+  UINT32 size = VertexElement::getTypeSize(attribute.type);
 
-    newVertex.position = Vector3(oldVertex.Position.x, oldVertex.Position.y, oldVertex.Position.z);
-    newVertex.normal = Vector3(oldVertex.Normal.x, oldVertex.Normal.y, oldVertex.Normal.z);
-    newVertex.texCoord = Vector2(oldVertex.TexCoord.x, oldVertex.TexCoord.y);
-    newVertex.color = oldVertex.Color;
-    newVertex.tangent = Vector3();
-    newVertex.bitangent = Vector3();
+  switch (attribute.semantic)
+  {
+    case VES_POSITION:
+      src = (const UINT8*)&vertices[0].Position;
+      break;
+
+    case VES_NORMAL:
+      src = (const UINT8*)&vertices[0].Normal;
+      break;
+
+    case VES_TEXCOORD:
+      src = (const UINT8*)&vertices[0].TexCoord;
+      break;
 
-    v.push_back(newVertex);
+    case VES_COLOR:
+      src = (const UINT8*)&vertices[0].Color;
+      break;
+
+    default:
+      break;
   }
 
-  return v;
+  for (size_t i = 0; i < vertices.size(); i++, dst += stride)
+  {
+    if (src)
+    {
+      memcpy(dst, src + i * sizeof(ZenLoad::WorldVertex), size);
+    }
+    else
+    {
+      memset(dst, 0, size);
+    }
+  }
 }
 
-static void transferVertices(SPtr<MeshData> target, const Vector<StaticMeshVertex>& vertices)
+/**
+ * Maps each component from [-1, 1] to [0, 255], as bs::MeshUtility::packNormals() does.
+ */
+static UINT32 packNormal(float x, float y, float z)
 {
-  assert(target->getNumVertices() == vertices.size());
+  auto toByte = [](float value) -> UINT32 {
+    float unsignedValue = Math::clamp(value * 0.5f + 0.5f, 0.0f, 1.0f);
+    return (UINT32)(unsignedValue * 255.0f + 0.5f);
+  };
 
-  UINT8* pVertices = target->getElementData(VES_POSITION);
-  memcpy(pVertices, vertices.data(), sizeof(StaticMeshVertex) * vertices.size());
+  return toByte(x) | (toByte(y) << 8) | (toByte(z) << 16);
 }
 
+/**
+ * Copies the indices of all submeshes, narrowing them if the target has 16-bit indices.
+ */
 static void transferIndices(SPtr<MeshData> target, const ZenLoad::PackedMesh& packedMesh)
 {
-  UINT32* pIndices = target->getIndices32();
   size_t writtenSoFar = 0;
 
   for (const auto& submesh : packedMesh.subMeshes)
   {
-    memcpy(&pIndices[writtenSoFar], submesh.indices.data(), sizeof(UINT32) * submesh.indices.size());
+    if (target->getIndexType() == IT_16BIT)
+    {
+      BsZenLib::NarrowIndices(submesh.indices.data(), &target->getIndices16()[writtenSoFar],
+                              submesh.indices.size());
+    }
+    else
+    {
+      memcpy(&target->getIndices32()[writtenSoFar], submesh.indices.data(),
+             sizeof(UINT32) * submesh.indices.size());
+    }
+
     writtenSoFar += submesh.indices.size();
   }
 }
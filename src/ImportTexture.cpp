@@ -18,74 +18,471 @@
  * "SAMPLE-C.TEX", which is the compiled ZTEX file.
  *
  * In case there is no such compiled ZTEX file, we will try to load the original TGA file instead.
+ *
+ *
+ * Compressed textures
+ * -------------------
+ *
+ * Almost all textures of the game are DXT1 or DXT5 compressed. Those are handed to bs::f
+ * straight out of the buffer read from the VDFS: Only the zTEX-header is parsed and every
+ * mip-map level is passed on as a slice of the original data, without converting the whole
+ * file to DDS first.
+ *
+ * Uncompressed and paletted textures are decoded to 32-bit RGBA right here. Where each channel
+ * sits inside a pixel is described by a table (see ZTEX_PIXEL_LAYOUTS), so all formats share
+ * the same decoder. With SSE2 available, 16- and 32-bit pixels are decoded several at a time.
  */
 
 #include "ImportTexture.hpp"
+#include "CachePack.hpp"
+#include "ImportMetrics.hpp"
 #include "ImportPath.hpp"
+#include "InFlightImports.hpp"
+#include "ParallelFor.hpp"
 #include "ResourceManifest.hpp"
-#include <FileSystem/BsFileSystem.h>
-#include <Image/BsColor.h>
+#include "ScratchBuffer.hpp"
+#include "TextureCompression.hpp"
+#include "TextureIndex.hpp"
+#include "TextureMipMaps.hpp"
+#include "TextureStreaming.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <Image/BsPixelData.h>
 #include <Image/BsTexture.h>
 #include <Resources/BsResources.h>
+#include <Threading/BsThreading.h>
 #include <vdfs/fileIndex.h>
-#include <zenload/ztex2dds.h>
-
-#ifndef BSZENLIB_ENABLE_FREEIMAGE
-#define BSZENLIB_ENABLE_FREEIMAGE 0
-#endif
 
-#if BSZENLIB_ENABLE_FREEIMAGE
-#include <FreeImage.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BSZENLIB_USE_SSE2 1
+#include <emmintrin.h>
+#else
+#define BSZENLIB_USE_SSE2 0
 #endif
 
 using namespace bs;
 using namespace BsZenLib;
 
+/**
+ * Bump this whenever the output of the texture importer changes so caches get rebuilt.
+ */
+static constexpr UINT32 TEXTURE_IMPORTER_VERSION = 5;
+
+/**
+ * Filter used to generate the mip-maps of uncompressed textures, see SetTextureMipFilter().
+ */
+static std::atomic<TextureMipFilter> s_MipFilter{TextureMipFilter::Kaiser};
+
+/**
+ * Compression applied to uncompressed textures, see SetTextureCompression().
+ */
+static Mutex s_CompressionMutex;
+static TextureCompressionOptions s_Compression;
+
+/**
+ * Magic number at the start of every compiled texture, "ZTEX".
+ */
+static constexpr UINT32 ZTEX_SIGNATURE = 0x5845545A;
+
+/**
+ * Formats of the zTEX header, as written by the game.
+ */
+enum class ZTEXFormat : UINT32
+{
+  B8G8R8A8 = 0,
+  R8G8B8A8 = 1,
+  A8B8G8R8 = 2,
+  A8R8G8B8 = 3,
+  B8G8R8 = 4,
+  R8G8B8 = 5,
+  A4R4G4B4 = 6,
+  A1R5G5B5 = 7,
+  R5G6B5 = 8,
+  P8 = 9,
+  DXT1 = 10,
+  DXT2 = 11,
+  DXT3 = 12,
+  DXT4 = 13,
+  DXT5 = 14,
+};
+
+/**
+ * Header at the start of a compiled texture, followed by the mip-map levels, smallest first.
+ * All values are stored little endian.
+ */
+struct ZTEXHeader
+{
+  UINT32 signature;
+  UINT32 version;
+  UINT32 format;
+  UINT32 width;
+  UINT32 height;
+  UINT32 numMips;  // Including the base level
+  UINT32 referenceWidth;
+  UINT32 referenceHeight;
+  UINT32 averageColor;
+};
+
+static_assert(sizeof(ZTEXHeader) == 36, "zTEX header must match the file layout");
+
+/**
+ * Paletted textures store 256 colors between the header and the first mip-map level.
+ */
+static constexpr UINT32 ZTEX_PALETTE_SIZE = 256 * 4;
+
+/**
+ * Description and pixels of all mip-map levels of a texture, largest first.
+ */
+struct TextureLevels
+{
+  TEXTURE_DESC desc;
+  Vector<SPtr<PixelData>> levels;
+};
+
+/**
+ * Position of one color channel inside a pixel, which is read as a little endian integer.
+ * Channels with 0 bits are not stored and decode as fully opaque.
+ */
+struct ZTEXChannel
+{
+  UINT32 shift;
+  UINT32 numBits;
+};
+
+/**
+ * Layout of the pixels of one of the uncompressed zTEX-formats.
+ */
+struct ZTEXPixelLayout
+{
+  ZTEXFormat format;
+  UINT32 bytesPerPixel;
+  ZTEXChannel red;
+  ZTEXChannel green;
+  ZTEXChannel blue;
+  ZTEXChannel alpha;
+};
+
+/**
+ * The 8-bit formats are named by their order in memory, the 16-bit ones by the order of their
+ * bits, highest first.
+ */
+static const ZTEXPixelLayout ZTEX_PIXEL_LAYOUTS[] = {
+    // Format, bytes per pixel, red, green, blue, alpha
+    {ZTEXFormat::B8G8R8A8, 4, {16, 8}, {8, 8}, {0, 8}, {24, 8}},
+    {ZTEXFormat::R8G8B8A8, 4, {0, 8}, {8, 8}, {16, 8}, {24, 8}},
+    {ZTEXFormat::A8B8G8R8, 4, {24, 8}, {16, 8}, {8, 8}, {0, 8}},
+    {ZTEXFormat::A8R8G8B8, 4, {8, 8}, {16, 8}, {24, 8}, {0, 8}},
+    {ZTEXFormat::B8G8R8, 3, {16, 8}, {8, 8}, {0, 8}, {0, 0}},
+    {ZTEXFormat::R8G8B8, 3, {0, 8}, {8, 8}, {16, 8}, {0, 0}},
+    {ZTEXFormat::A4R4G4B4, 2, {8, 4}, {4, 4}, {0, 4}, {12, 4}},
+    {ZTEXFormat::A1R5G5B5, 2, {10, 5}, {5, 5}, {0, 5}, {15, 1}},
+    {ZTEXFormat::R5G6B5, 2, {11, 5}, {5, 6}, {0, 5}, {0, 0}},
+    {ZTEXFormat::P8, 1, {0, 0}, {0, 0}, {0, 0}, {0, 0}},  // Index into the palette
+};
+
+static HTexture importAndCacheTexture(const String& virtualFilePath, const VDFS::FileIndex& vdfs,
+                                      std::vector<uint8_t>& ztexData);
+static void readAndStampTexture(const String& virtualFilePath, const VDFS::FileIndex& vdfs,
+                                std::vector<uint8_t>& outData, CacheSourceStamp& outStamp);
+static HTexture cacheTextureFromZTEX(const String& virtualFilePath,
+                                     const std::vector<uint8_t>& ztexData,
+                                     const CacheSourceStamp& stamp);
+static HTexture importTextureFromZTEX(const String& path, const std::vector<uint8_t>& ztexData,
+                                      HTexture* outTail = nullptr,
+                                      bool outlivesBuffer = false);
+static UINT32 textureImporterVersion(const std::vector<uint8_t>& ztexData);
+static bool isCachedTextureUpToDate(const String& name, const CacheSourceStamp& stamp);
+static bool hasCachedTextureFile(const String& name);
+static CachedTextureInfo makeCachedTextureInfo(const String& name, const HTexture& texture,
+                                               const CacheSourceStamp& stamp);
+static String compiledTextureName(const String& path);
 static std::vector<uint8_t> readCompiledTexture(const String& path, const VDFS::FileIndex& vdfs);
+static void readCompiledTexture(const String& path, const VDFS::FileIndex& vdfs,
+                                std::vector<uint8_t>& outData);
 static String replaceExtension(const String& path, const String& newExtension);
-static HTexture createRGBA8Texture(const String& name, UINT32 width, UINT32 height,
-                                   const std::vector<uint8_t>& rgbaData);
-static HTexture createDXTnTexture(const String& name, std::vector<uint8_t>& ddsData,
-                                  const ZenLoad::DDSURFACEDESC2& surfaceDesc);
-static std::vector<bs::UINT8> convertToRGBA8(std::vector<uint8_t>& ddsData);
+static void makeRGBA8Levels(UINT32 width, UINT32 height, const std::vector<uint8_t>& rgbaData,
+                            TextureLevels& outLevels);
+static bool parseZTEXHeader(const std::vector<uint8_t>& ztexData, ZTEXHeader& outHeader);
+static PixelFormat compressedPixelFormatOf(const ZTEXHeader& header);
+static const ZTEXPixelLayout* findPixelLayout(const ZTEXHeader& header);
+static UINT64 ztexMipSize(const ZTEXHeader& header, UINT32 mipLevel);
+static UINT64 ztexMipOffset(const ZTEXHeader& header, UINT32 mipLevel);
+static void makeDXTnLevels(const std::vector<uint8_t>& ztexData, const ZTEXHeader& header,
+                           PixelFormat format, TextureLevels& outLevels);
+static void copyIntoOwnBuffers(TextureLevels& levels);
+static HTexture createTexture(const String& name, const TextureLevels& levels,
+                              UINT32 firstLevel);
+static UINT32 findTailLevel(const TextureLevels& levels);
+static void decodeToRGBA8(const std::vector<uint8_t>& ztexData, const ZTEXHeader& header,
+                          std::vector<uint8_t>& outRGBA);
+static void decodePixels(const UINT8* src, UINT8* dst, size_t numPixels,
+                         const ZTEXPixelLayout& layout);
+static void decodePalettedPixels(const UINT8* palette, const UINT8* src, UINT8* dst,
+                                 size_t numPixels);
+static UINT8 expandToByte(UINT32 value, UINT32 numBits);
 
 // - Implementation --------------------------------------------------------------------------------
 
 bool BsZenLib::HasCachedTexture(const String& virtualFilePath)
 {
-  return HasCachedResource(GothicPathToCachedTexture(virtualFilePath.c_str()));
+  CachedTextureInfo info;
+  if (!FindCachedTextureInfo(virtualFilePath, info)) return false;
+
+  // Only the importer itself, the settings it ran with don't keep the texture from loading
+  if ((info.importerVersion & 0xFFFF) != TEXTURE_IMPORTER_VERSION) return false;
+
+  return hasCachedTextureFile(virtualFilePath);
+}
+
+bool BsZenLib::HasCachedTexture(const String& virtualFilePath, const VDFS::FileIndex& vdfs)
+{
+  // The version depends on the format of the compiled texture, so it has to be read anyways
+  ScratchBuffer<std::vector<uint8_t>> ztexData;
+  CacheSourceStamp stamp;
+  readAndStampTexture(virtualFilePath, vdfs, *ztexData, stamp);
+
+  if (ztexData->empty()) return HasCachedTexture(virtualFilePath);
+
+  return isCachedTextureUpToDate(virtualFilePath, stamp);
 }
 
 HTexture BsZenLib::LoadCachedTexture(const String& virtualFilePath)
 {
   Path path = GothicPathToCachedTexture(virtualFilePath.c_str());
 
-  return gResources().load<Texture>(path);
+  return LoadCachedResource<Texture>(path);
 }
 
 bs::HTexture BsZenLib::ImportAndCacheTexture(const bs::String& virtualFilePath,
                                              const VDFS::FileIndex& vdfs)
+{
+  Path path = GothicPathToCachedTexture(virtualFilePath.c_str());
+
+  return ImportOnce<Texture>(path, [&]() {
+    ScratchBuffer<std::vector<uint8_t>> ztexData;
+    return importAndCacheTexture(virtualFilePath, vdfs, *ztexData);
+  });
+}
+
+bs::Vector<bs::HTexture> BsZenLib::ImportAndCacheTextures(const Vector<String>& originalFileNames,
+                                                          const VDFS::FileIndex& vdfs,
+                                                          const TextureBatchOptions& options)
+{
+  // Every name only once. Sorted, so the same list always imports in the same order.
+  Vector<String> unique = originalFileNames;
+  std::sort(unique.begin(), unique.end());
+  unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+  BS_LOG(Info, Uncategorized, "Caching {0} Textures", (UINT32)unique.size());
+
+  Vector<HTexture> imported(unique.size());
+
+  // Jobs take the next texture whenever they are done with one, so a few large textures can't
+  // hold up the ones queued behind them. Without a limit, every texture gets its own job and
+  // the task scheduler decides how many of them run at once.
+  UINT32 numTextures = (UINT32)unique.size();
+  UINT32 numJobs = numTextures;
+  if (options.maxJobs > 0) numJobs = std::min(numJobs, options.maxJobs);
+
+  std::atomic<UINT32> nextTexture{0};
+
+  ParallelFor(numJobs, 1, [&](UINT32, UINT32) {
+    for (UINT32 i = nextTexture++; i < numTextures; i = nextTexture++)
+    {
+      const String& name = unique[i];
+
+      // Read only once, for both checking the cache and importing
+      ScratchBuffer<std::vector<uint8_t>> ztexData;
+      CacheSourceStamp stamp;
+      readAndStampTexture(name, vdfs, *ztexData, stamp);
+
+      if (options.reuseCached)
+      {
+        // Without a compiled texture, the cache can't be checked, same as HasCachedTexture()
+        bool isUpToDate =
+            ztexData->empty() ? HasCachedTexture(name) : isCachedTextureUpToDate(name, stamp);
+
+        if (isUpToDate)
+        {
+          imported[i] = LoadCachedTexture(name);
+
+          if (imported[i]) continue;
+        }
+      }
+
+      Path path = GothicPathToCachedTexture(name.c_str());
+
+      imported[i] = ImportOnce<Texture>(path, [&]() {
+        BS_LOG(Info, Uncategorized, "Caching Texture: " + name);
+        return cacheTextureFromZTEX(name, *ztexData, stamp);
+      });
+    }
+  });
+
+  Vector<HTexture> result;
+  result.reserve(originalFileNames.size());
+
+  for (const String& name : originalFileNames)
+  {
+    size_t index = std::lower_bound(unique.begin(), unique.end(), name) - unique.begin();
+    result.push_back(imported[index]);
+  }
+
+  return result;
+}
+
+void BsZenLib::SetTextureMipFilter(TextureMipFilter filter)
+{
+  s_MipFilter.store(filter);
+}
+
+TextureMipFilter BsZenLib::GetTextureMipFilter()
+{
+  return s_MipFilter.load();
+}
+
+void BsZenLib::SetTextureCompression(const TextureCompressionOptions& options)
+{
+  Lock lock(s_CompressionMutex);
+  s_Compression = options;
+}
+
+TextureCompressionOptions BsZenLib::GetTextureCompression()
+{
+  Lock lock(s_CompressionMutex);
+  return s_Compression;
+}
+
+HTexture BsZenLib::ImportTexture(const String& path, const VDFS::FileIndex& vdfs)
+{
+  std::vector<uint8_t> ztexData = readCompiledTexture(path, vdfs);
+
+  const bool outlivesBuffer = true;
+  return importTextureFromZTEX(path, ztexData, nullptr, outlivesBuffer);
+}
+
+HTexture BsZenLib::ImportTexture(const String& name, const std::vector<uint8_t>& ztexData)
+{
+  const bool outlivesBuffer = true;
+  return importTextureFromZTEX(name, ztexData, nullptr, outlivesBuffer);
+}
+
+/**
+ * @param ztexData  Buffer to read the compiled texture into. Its contents are only needed until
+ *                  this returns, so it can be reused for the next texture.
+ */
+static HTexture importAndCacheTexture(const String& virtualFilePath, const VDFS::FileIndex& vdfs,
+                                      std::vector<uint8_t>& ztexData)
 {
   BS_LOG(Info, Uncategorized, "Caching Texture: " + virtualFilePath);
 
-  HTexture fromOriginal = ImportTexture(virtualFilePath, vdfs);
+  CacheSourceStamp stamp;
+  readAndStampTexture(virtualFilePath, vdfs, ztexData, stamp);
+
+  return cacheTextureFromZTEX(virtualFilePath, ztexData, stamp);
+}
+
+/**
+ * Reads the compiled texture into the given buffer and builds the stamp a texture cached from
+ * it gets. See HasCachedTexture() on how to check against it.
+ */
+static void readAndStampTexture(const String& virtualFilePath, const VDFS::FileIndex& vdfs,
+                                std::vector<uint8_t>& outData, CacheSourceStamp& outStamp)
+{
+  {
+    ScopedImportTimer timer("Texture", "ReadVDFS", virtualFilePath);
+    readCompiledTexture(virtualFilePath, vdfs, outData);
+    timer.setBytesOut(outData.size());
+  }
+
+  ScopedImportTimer timer("Texture", "Hash", virtualFilePath);
+  timer.setBytesIn(outData.size());
+
+  outStamp.sourceHash = HashSourceData(outData.data(), outData.size());
+  outStamp.importerVersion = textureImporterVersion(outData);
+}
+
+/**
+ * Imports the given compiled texture and saves it into the cache, along with its tail. The
+ * texture is saved before this returns, so it does not need the buffer afterwards.
+ */
+static HTexture cacheTextureFromZTEX(const String& virtualFilePath,
+                                     const std::vector<uint8_t>& ztexData,
+                                     const CacheSourceStamp& stamp)
+{
+  HTexture tail;
+  HTexture fromOriginal = importTextureFromZTEX(virtualFilePath, ztexData, &tail);
 
   if (!fromOriginal) return {};
 
   const bool overwrite = true;
   Path path = GothicPathToCachedTexture(virtualFilePath.c_str());
+  Path tailPath = GothicPathToCachedTextureTail(virtualFilePath.c_str());
+
+  {
+    ScopedImportTimer timer("Texture", "Save", virtualFilePath);
+    gResources().save(fromOriginal, path, overwrite);
+    timer.setBytesOutFromFile(path);
+  }
+
+  // Textures small enough to be their own tail don't get a separate one
+  if (tail)
+  {
+    ScopedImportTimer timer("Texture", "SaveTail", virtualFilePath);
+    gResources().save(tail, tailPath, overwrite);
+    timer.setBytesOutFromFile(tailPath);
+  }
+
+  {
+    ScopedImportTimer timer("Texture", "Manifest", virtualFilePath);
+    AddToResourceManifest(fromOriginal, path, stamp);
 
-  gResources().save(fromOriginal, path, overwrite);
-  AddToResourceManifest(fromOriginal, path);
+    if (tail) AddToResourceManifest(tail, tailPath, stamp);
+
+    AddToTextureIndex(makeCachedTextureInfo(virtualFilePath, fromOriginal, stamp));
+  }
 
   return fromOriginal;
 }
 
-HTexture BsZenLib::ImportTexture(const String& path, const VDFS::FileIndex& vdfs)
+static CachedTextureInfo makeCachedTextureInfo(const String& name, const HTexture& texture,
+                                               const CacheSourceStamp& stamp)
 {
-  std::vector<uint8_t> ztexData = readCompiledTexture(path, vdfs);
+  const TextureProperties& properties = texture->getProperties();
+
+  CachedTextureInfo info;
+  info.name = name;
+  info.width = properties.getWidth();
+  info.height = properties.getHeight();
+  info.numMips = properties.getNumMipmaps() + 1;
+  info.format = properties.getFormat();
+  info.sourceHash = stamp.sourceHash;
+  info.importerVersion = stamp.importerVersion;
+
+  for (UINT32 i = 0; i < info.numMips; i++)
+  {
+    UINT32 mipWidth, mipHeight, mipDepth;
+    PixelUtil::getSizeForMipLevel(info.width, info.height, 1, i, mipWidth, mipHeight, mipDepth);
 
+    info.memorySize += PixelUtil::getMemorySize(mipWidth, mipHeight, mipDepth, info.format);
+  }
+
+  return info;
+}
+
+/**
+ * @param outTail         If set, receives the tail of the texture for streaming, see
+ *                        LoadCachedTextureTail(). Stays empty if the texture is small enough
+ *                        already. Only set when caching, which also keeps a copy of the
+ *                        textures on the CPU, see below.
+ * @param outlivesBuffer  Whether the texture is used after the zTEX-buffer is gone. Writing to
+ *                        a texture only queues the upload, so the levels then need their own
+ *                        copy. Not needed if the texture is saved while the buffer is around.
+ */
+static HTexture importTextureFromZTEX(const String& path, const std::vector<uint8_t>& ztexData,
+                                      HTexture* outTail, bool outlivesBuffer)
+{
   if (ztexData.empty())
   {
     BS_LOG(Warning, Uncategorized, "Import of uncompiled textures is not implemented! ({0})", path);
@@ -93,73 +490,370 @@ HTexture BsZenLib::ImportTexture(const String& path, const VDFS::FileIndex& vdfs
     return HTexture();
   }
 
-  std::vector<uint8_t> ddsData;
-  ZenLoad::convertZTEX2DDS(ztexData, ddsData);
+  ZTEXHeader header;
+  if (!parseZTEXHeader(ztexData, header))
+  {
+    BS_LOG(Warning, Uncategorized, "Not a valid zTEX-texture: {0}", path);
+
+    return HTexture();
+  }
 
-  ZenLoad::DDSURFACEDESC2 surfaceDesc = ZenLoad::getSurfaceDesc(ddsData);
+  PixelFormat compressedFormat = compressedPixelFormatOf(header);
+  TextureLevels levels;
 
-  // Load uncompressed DDS textures
-  if ((surfaceDesc.ddpfPixelFormat.dwFlags & ZenLoad::DDPF_FOURCC) != 0)
+  if (compressedFormat == PF_UNKNOWN)
   {
-    // Optionally convert to RGBA8, which is easier to work with.
-    // Commented out because it's usually only needed during testing.
-    /*
-    std::vector<uint8_t> rgbaData;
-    ZenLoad::convertDDSToRGBA8(ddsData, rgbaData);
-    return createRGBA8Texture(path, surfaceDesc.dwWidth, surfaceDesc.dwHeight, rgbaData);
-    */
+    ScratchBuffer<std::vector<uint8_t>> rgbaData;
+    {
+      ScopedImportTimer timer("Texture", "DecodeZTEX", path);
+      decodeToRGBA8(ztexData, header, *rgbaData);
 
-    return createDXTnTexture(path, ddsData, surfaceDesc);
+      timer.setBytesIn(ztexData.size());
+      timer.setBytesOut(rgbaData->size());
+    }
+
+    ScopedImportTimer timer("Texture", "CreateTexture", path);
+    timer.setBytesIn(rgbaData->size());
+
+    makeRGBA8Levels(header.width, header.height, *rgbaData, levels);
   }
   else
   {
-#if BSZENLIB_ENABLE_FREEIMAGE
-    // Uncompressed or weird DDS textures are converted to 32bit RGBA
-    auto rgbaData = convertToRGBA8(ddsData);
+    ScopedImportTimer timer("Texture", "CreateTexture", path);
+    timer.setBytesIn(ztexData.size());
 
-    return createRGBA8Texture(path, surfaceDesc.dwWidth, surfaceDesc.dwHeight, rgbaData);
-#else
+    // Those point into the zTEX-buffer, which must outlive the textures created below
+    makeDXTnLevels(ztexData, header, compressedFormat, levels);
 
-    BS_LOG(Warning, Uncategorized,
-           "Will not import uncompressed texture {0} - FreeImage support is disabled", path);
-    return {};
+    if (outlivesBuffer) copyIntoOwnBuffers(levels);
+  }
 
-#endif
+  // Saving reads the texture back, which the null render API used by bszen-cache can't do from
+  // the GPU. Only the textures being cached get a tail, so only those need the copy.
+  if (outTail) levels.desc.usage |= TU_CPUCACHED;
+
+  HTexture texture = createTexture(path, levels, 0);
+
+  if (outTail)
+  {
+    UINT32 tailLevel = findTailLevel(levels);
+
+    if (tailLevel > 0 && tailLevel < levels.levels.size())
+    {
+      *outTail = createTexture(path, levels, tailLevel);
+    }
   }
+
+  return texture;
 }
 
-#if BSZENLIB_ENABLE_FREEIMAGE
-static std::vector<bs::UINT8> convertToRGBA8(std::vector<uint8_t>& ddsData)
+/**
+ * Checks the magic number and whether the buffer is large enough to hold all mip-map levels
+ * the header says it has.
+ */
+static bool parseZTEXHeader(const std::vector<uint8_t>& ztexData, ZTEXHeader& outHeader)
 {
-  FreeImage_Initialise();
+  if (ztexData.size() < sizeof(ZTEXHeader)) return false;
 
-  auto stream = FreeImage_OpenMemory(ddsData.data(), ddsData.size());
+  memcpy(&outHeader, ztexData.data(), sizeof(ZTEXHeader));
 
-  auto imageEncoded = FreeImage_LoadFromMemory(FIF_DDS, stream);
-  auto imageRGBA8 = FreeImage_ConvertTo32Bits(imageEncoded);
+  if (outHeader.signature != ZTEX_SIGNATURE) return false;
+  if (outHeader.width == 0 || outHeader.height == 0) return false;
+  if (outHeader.numMips == 0 || outHeader.numMips > 32) return false;
 
-  auto imageBytes = FreeImage_GetBits(imageRGBA8);
-  auto width = FreeImage_GetWidth(imageRGBA8);
-  auto height = FreeImage_GetHeight(imageRGBA8);
+  if (compressedPixelFormatOf(outHeader) == PF_UNKNOWN && !findPixelLayout(outHeader))
+  {
+    return false;
+  }
 
-  auto imageNumBytes = 4 * width * height;
+  // The base level is stored last
+  return ztexMipOffset(outHeader, 0) + ztexMipSize(outHeader, 0) <= ztexData.size();
+}
 
-  std::vector<bs::UINT8> rgbaData(imageBytes, imageBytes + imageNumBytes);
+/**
+ * @return Block compressed format matching the one of the zTEX, PF_UNKNOWN if it is not
+ *         one bs::f can take as is.
+ */
+static PixelFormat compressedPixelFormatOf(const ZTEXHeader& header)
+{
+  switch ((ZTEXFormat)header.format)
+  {
+    case ZTEXFormat::DXT1:
+      return PF_BC1;
 
-  FreeImage_Unload(imageEncoded);
-  FreeImage_Unload(imageRGBA8);
-  FreeImage_CloseMemory(stream);
+    // DXT2 and DXT4 only differ by having premultiplied alpha, which is kept as it is
+    case ZTEXFormat::DXT2:
+    case ZTEXFormat::DXT3:
+      return PF_BC2;
 
-  FreeImage_DeInitialise();
+    case ZTEXFormat::DXT4:
+    case ZTEXFormat::DXT5:
+      return PF_BC3;
 
-  return rgbaData;
+    default:
+      return PF_UNKNOWN;
+  }
+}
+
+/**
+ * @return Layout of the pixels, if the zTEX is uncompressed. nullptr otherwise.
+ */
+static const ZTEXPixelLayout* findPixelLayout(const ZTEXHeader& header)
+{
+  for (const ZTEXPixelLayout& layout : ZTEX_PIXEL_LAYOUTS)
+  {
+    if ((UINT32)layout.format == header.format) return &layout;
+  }
+
+  return nullptr;
+}
+
+/**
+ * @return Number of bytes the given mip-map level takes up inside the zTEX-file.
+ */
+static UINT64 ztexMipSize(const ZTEXHeader& header, UINT32 mipLevel)
+{
+  UINT32 mipWidth, mipHeight, mipDepth;
+  PixelUtil::getSizeForMipLevel(header.width, header.height, 1, mipLevel, mipWidth, mipHeight,
+                                mipDepth);
+
+  PixelFormat compressedFormat = compressedPixelFormatOf(header);
+
+  if (compressedFormat != PF_UNKNOWN)
+  {
+    return PixelUtil::getMemorySize(mipWidth, mipHeight, mipDepth, compressedFormat);
+  }
+
+  const ZTEXPixelLayout* layout = findPixelLayout(header);
+
+  return layout ? (UINT64)mipWidth * mipHeight * layout->bytesPerPixel : 0;
+}
+
+/**
+ * @return Where the given mip-map level starts inside the zTEX-file. Levels are stored smallest
+ *         first, so the base level comes last.
+ */
+static UINT64 ztexMipOffset(const ZTEXHeader& header, UINT32 mipLevel)
+{
+  UINT64 offset = sizeof(ZTEXHeader);
+
+  if (header.format == (UINT32)ZTEXFormat::P8)
+  {
+    offset += ZTEX_PALETTE_SIZE;
+  }
+
+  for (UINT32 i = header.numMips - 1; i > mipLevel; i--)
+  {
+    offset += ztexMipSize(header, i);
+  }
+
+  return offset;
+}
+
+/**
+ * Decodes the base level of an uncompressed or paletted zTEX to 32-bit RGBA. The header must
+ * have been validated by parseZTEXHeader().
+ */
+static void decodeToRGBA8(const std::vector<uint8_t>& ztexData, const ZTEXHeader& header,
+                          std::vector<uint8_t>& outRGBA)
+{
+  const ZTEXPixelLayout& layout = *findPixelLayout(header);
+  const UINT8* src = &ztexData[ztexMipOffset(header, 0)];
+  size_t numPixels = (size_t)header.width * header.height;
+
+  outRGBA.resize(numPixels * 4);
+
+  if (layout.format == ZTEXFormat::P8)
+  {
+    const UINT8* palette = &ztexData[sizeof(ZTEXHeader)];
+    decodePalettedPixels(palette, src, outRGBA.data(), numPixels);
+  }
+  else
+  {
+    decodePixels(src, outRGBA.data(), numPixels, layout);
+  }
+}
+
+/**
+ * Turns one channel of a pixel into 8 bits. Every possible value of the channel is looked up in
+ * a table, so channels with less than 8 bits don't need to be scaled one pixel at a time.
+ */
+struct ChannelDecoder
+{
+  UINT32 shift;
+  UINT32 mask;
+  UINT8 expanded[256];
+
+  explicit ChannelDecoder(const ZTEXChannel& channel)
+      : shift(channel.shift), mask((1u << channel.numBits) - 1)
+  {
+    if (channel.numBits == 0)
+    {
+      expanded[0] = 255;  // Not stored, ie. alpha of R5G6B5
+      return;
+    }
+
+    for (UINT32 value = 0; value <= mask; value++)
+    {
+      expanded[value] = expandToByte(value, channel.numBits);
+    }
+  }
+
+  UINT8 decode(UINT32 pixel) const { return expanded[(pixel >> shift) & mask]; }
+};
+
+#if BSZENLIB_USE_SSE2
+/**
+ * Decodes 4 pixels of a format with four 8-bit channels at once.
+ */
+static __m128i decodePixels32SSE2(__m128i pixels, const ZTEXPixelLayout& layout)
+{
+  const __m128i byteMask = _mm_set1_epi32(0xFF);
+
+  __m128i r = _mm_srl_epi32(pixels, _mm_cvtsi32_si128(layout.red.shift));
+  __m128i g = _mm_srl_epi32(pixels, _mm_cvtsi32_si128(layout.green.shift));
+  __m128i b = _mm_srl_epi32(pixels, _mm_cvtsi32_si128(layout.blue.shift));
+  __m128i a = _mm_srl_epi32(pixels, _mm_cvtsi32_si128(layout.alpha.shift));
+
+  r = _mm_and_si128(r, byteMask);
+  g = _mm_slli_epi32(_mm_and_si128(g, byteMask), 8);
+  b = _mm_slli_epi32(_mm_and_si128(b, byteMask), 16);
+  a = _mm_slli_epi32(_mm_and_si128(a, byteMask), 24);
+
+  return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+/**
+ * Extracts one channel of 8 16-bit pixels and repeats its bits to fill 8 bits, the same way
+ * expandToByte() does. Channels of the 16-bit formats have 0, 1, 4, 5 or 6 bits.
+ */
+static __m128i expandChannel16SSE2(__m128i pixels, const ZTEXChannel& channel)
+{
+  if (channel.numBits == 0) return _mm_set1_epi16(255);
+
+  __m128i mask = _mm_set1_epi16((short)((1 << channel.numBits) - 1));
+  __m128i value = _mm_and_si128(_mm_srl_epi16(pixels, _mm_cvtsi32_si128(channel.shift)), mask);
+
+  if (channel.numBits == 1) return _mm_mullo_epi16(value, _mm_set1_epi16(255));
+
+  __m128i high = _mm_sll_epi16(value, _mm_cvtsi32_si128(8 - channel.numBits));
+  __m128i low = _mm_srl_epi16(value, _mm_cvtsi32_si128(2 * channel.numBits - 8));
+
+  return _mm_or_si128(high, low);
+}
+
+/**
+ * Decodes 8 pixels of a 16-bit format at once, writing 32 bytes.
+ */
+static void decodePixels16SSE2(__m128i pixels, const ZTEXPixelLayout& layout, UINT8* dst)
+{
+  __m128i r = expandChannel16SSE2(pixels, layout.red);
+  __m128i g = expandChannel16SSE2(pixels, layout.green);
+  __m128i b = expandChannel16SSE2(pixels, layout.blue);
+  __m128i a = expandChannel16SSE2(pixels, layout.alpha);
+
+  // Every 16-bit lane now holds two channels of one pixel
+  __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+  __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+
+  _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(rg, ba));
+  _mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi16(rg, ba));
 }
 #endif
 
-static HTexture createRGBA8Texture(const String& name, UINT32 width, UINT32 height,
-                                   const std::vector<uint8_t>& rgbaData)
+static void decodePixels(const UINT8* src, UINT8* dst, size_t numPixels,
+                         const ZTEXPixelLayout& layout)
+{
+  size_t i = 0;
+
+#if BSZENLIB_USE_SSE2
+  if (layout.bytesPerPixel == 4)
+  {
+    for (; i + 4 <= numPixels; i += 4)
+    {
+      __m128i pixels = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+      _mm_storeu_si128((__m128i*)(dst + 4 * i), decodePixels32SSE2(pixels, layout));
+    }
+  }
+  else if (layout.bytesPerPixel == 2)
+  {
+    for (; i + 8 <= numPixels; i += 8)
+    {
+      __m128i pixels = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+      decodePixels16SSE2(pixels, layout, dst + 4 * i);
+    }
+  }
+#endif
+
+  if (i == numPixels) return;
+
+  // Whatever is left, 24-bit formats, or no SSE2
+  const ChannelDecoder red(layout.red);
+  const ChannelDecoder green(layout.green);
+  const ChannelDecoder blue(layout.blue);
+  const ChannelDecoder alpha(layout.alpha);
+
+  for (; i < numPixels; i++)
+  {
+    const UINT8* in = src + layout.bytesPerPixel * i;
+
+    UINT32 pixel = 0;
+    for (UINT32 j = 0; j < layout.bytesPerPixel; j++)
+    {
+      pixel |= (UINT32)in[j] << (8 * j);
+    }
+
+    UINT8* out = dst + 4 * i;
+    out[0] = red.decode(pixel);
+    out[1] = green.decode(pixel);
+    out[2] = blue.decode(pixel);
+    out[3] = alpha.decode(pixel);
+  }
+}
+
+/**
+ * Palette entries are stored as B, G, R and an unused fourth byte, so paletted textures are
+ * always opaque.
+ */
+static void decodePalettedPixels(const UINT8* palette, const UINT8* src, UINT8* dst,
+                                 size_t numPixels)
+{
+  UINT8 colors[256][4];
+
+  for (UINT32 i = 0; i < 256; i++)
+  {
+    colors[i][0] = palette[4 * i + 2];
+    colors[i][1] = palette[4 * i + 1];
+    colors[i][2] = palette[4 * i + 0];
+    colors[i][3] = 255;
+  }
+
+  for (size_t i = 0; i < numPixels; i++)
+  {
+    memcpy(dst + 4 * i, colors[src[i]], 4);
+  }
+}
+
+/**
+ * Scales a channel of less than 8 bits to the full range by repeating its bits, so that 0 stays
+ * 0 and the largest value becomes 255.
+ */
+static UINT8 expandToByte(UINT32 value, UINT32 numBits)
+{
+  UINT32 expanded = 0;
+
+  for (INT32 shift = 8 - (INT32)numBits; shift > -(INT32)numBits; shift -= (INT32)numBits)
+  {
+    expanded |= (shift >= 0) ? (value << shift) : (value >> -shift);
+  }
+
+  return (UINT8)expanded;
+}
+
+static void makeRGBA8Levels(UINT32 width, UINT32 height, const std::vector<uint8_t>& rgbaData,
+                            TextureLevels& outLevels)
 {
-  TEXTURE_DESC desc = {};
+  TEXTURE_DESC& desc = outLevels.desc;
   desc.type = TEX_TYPE_2D;
   desc.width = width;
   desc.height = height;
@@ -171,111 +865,209 @@ static HTexture createRGBA8Texture(const String& name, UINT32 width, UINT32 heig
                                                 desc.depth,   //
                                                 PixelFormat::PF_RGBA8);
 
-  std::vector<Color> colors;
-  size_t numPixels = desc.width * desc.height;
+  assert(pixelData->getSize() == rgbaData.size());
 
-  assert(numPixels * 4 == rgbaData.size());
+  // PF_RGBA8 has the same byte order as the input, so there is nothing to convert. Going through
+  // setColors() would turn every pixel into four floats and back.
+  memcpy(pixelData->getData(), rgbaData.data(), rgbaData.size());
 
-  for (size_t i = 0; i < numPixels; i++)
+  outLevels.levels = GenerateMipMapsRGBA8(*pixelData, s_MipFilter.load());
+  outLevels.levels.insert(outLevels.levels.begin(), pixelData);
+
+  TextureCompressionOptions compression = GetTextureCompression();
+  PixelFormat compressedFormat = ChooseCompressedFormat(*pixelData, compression.compression);
+
+  if (compressedFormat != PF_UNKNOWN)
+  {
+    for (SPtr<PixelData>& level : outLevels.levels)
+    {
+      level = CompressRGBA8(*level, compressedFormat, compression.quality, desc.hwGamma);
+    }
+
+    desc.format = compressedFormat;
+  }
+}
+
+/**
+ * Makes every mip-map level point into the given zTEX-buffer. The header must have been
+ * validated by parseZTEXHeader().
+ */
+static void makeDXTnLevels(const std::vector<uint8_t>& ztexData, const ZTEXHeader& header,
+                           PixelFormat format, TextureLevels& outLevels)
+{
+  TEXTURE_DESC& desc = outLevels.desc;
+  desc.type = TEX_TYPE_2D;
+  desc.width = header.width;
+  desc.height = header.height;
+  desc.format = format;
+  desc.hwGamma = true;
+
+  outLevels.levels.resize(header.numMips);
+
+  // Levels are stored smallest first, so the base level comes last
+  size_t mipOffset = sizeof(ZTEXHeader);
+
+  for (UINT32 i = header.numMips; i-- > 0;)
   {
-    colors.emplace_back(rgbaData[0 + 4 * i] / 255.0f,   // R
-                        rgbaData[1 + 4 * i] / 255.0f,   // G
-                        rgbaData[2 + 4 * i] / 255.0f,   // B
-                        rgbaData[3 + 4 * i] / 255.0f);  // A
+    UINT32 mipWidth, mipHeight, mipDepth;
+    PixelUtil::getSizeForMipLevel(desc.width, desc.height, 1, i, mipWidth, mipHeight, mipDepth);
+
+    SPtr<PixelData> pixelData = PixelData::create(mipWidth,   //
+                                                  mipHeight,  //
+                                                  mipDepth,   //
+                                                  format);
+
+    // bs::f only reads from the buffer, it never writes to it
+    pixelData->setExternalBuffer(const_cast<UINT8*>(&ztexData[mipOffset]));
+
+    outLevels.levels[i] = pixelData;
+
+    mipOffset += PixelUtil::getMemorySize(mipWidth, mipHeight, mipDepth, format);
   }
+}
 
-  pixelData->setColors(colors.data(), (UINT32)colors.size());
+/**
+ * Gives every level pointing into an outside buffer, like the ones made by makeDXTnLevels(), a
+ * copy of its own, so the levels stay valid once that buffer is gone.
+ */
+static void copyIntoOwnBuffers(TextureLevels& levels)
+{
+  for (SPtr<PixelData>& level : levels.levels)
+  {
+    SPtr<PixelData> copy = PixelData::create(level->getWidth(),   //
+                                             level->getHeight(),  //
+                                             level->getDepth(),   //
+                                             level->getFormat());
 
-  MipMapGenOptions mipMapGenOptions = {};
-  mipMapGenOptions.filter = MipMapFilter::Kaiser;
+    memcpy(copy->getData(), level->getData(), level->getSize());
 
-  Vector<SPtr<PixelData>> mipMapPixelData = PixelUtil::genMipmaps(*pixelData, mipMapGenOptions);
+    level = copy;
+  }
+}
+
+/**
+ * Creates a texture out of the given levels, starting at `firstLevel` as its base level.
+ * Every level is written exactly once.
+ */
+static HTexture createTexture(const String& name, const TextureLevels& levels,
+                              UINT32 firstLevel)
+{
+  TEXTURE_DESC desc = levels.desc;
+  desc.width = levels.levels[firstLevel]->getWidth();
+  desc.height = levels.levels[firstLevel]->getHeight();
+  desc.numMips = (UINT32)levels.levels.size() - firstLevel - 1;  // Without the base level
 
-  desc.numMips =
-      (UINT32)mipMapPixelData.size() - 1;  // -1 since the base level is not included in that count
   HTexture texture = Texture::create(desc);
 
-  for (size_t i = 0; i < mipMapPixelData.size(); i++)
+  for (UINT32 i = firstLevel; i < (UINT32)levels.levels.size(); i++)
   {
-    texture->writeData(mipMapPixelData[i], 0, (UINT32)i);
+    texture->writeData(levels.levels[i], 0, i - firstLevel);
   }
 
-  texture->writeData(pixelData);
   texture->setName(name);
 
   return texture;
 }
 
-static HTexture createDXTnTexture(const String& name, std::vector<uint8_t>& ddsData,
-                                  const ZenLoad::DDSURFACEDESC2& surfaceDesc)
+/**
+ * @return First level small enough to be part of the tail, or the number of levels if none is.
+ */
+static UINT32 findTailLevel(const TextureLevels& levels)
 {
-  TEXTURE_DESC desc = {};
-  desc.type = TEX_TYPE_2D;
-  desc.width = surfaceDesc.dwWidth;
-  desc.height = surfaceDesc.dwHeight;
-  desc.numMips = surfaceDesc.dwMipMapCount;
-  desc.hwGamma = true;
-
-  switch (surfaceDesc.ddpfPixelFormat.dwFourCC)
+  for (UINT32 i = 0; i < (UINT32)levels.levels.size(); i++)
   {
-    case MAKEFOURCC('D', 'X', 'T', '1'):
-      desc.format = PF_BC1;
-      break;
-
-    case MAKEFOURCC('D', 'X', 'T', '3'):
-      desc.format = PF_BC2;
-      break;
+    const PixelData& level = *levels.levels[i];
 
-    case MAKEFOURCC('D', 'X', 'T', '5'):
-      desc.format = PF_BC3;
-      break;
-    default:
-      BS_EXCEPT(InternalErrorException,
-                "Cannot import DXTn-texture " + name +
-                    ", unsupported FOURCC: " + bs::toString(surfaceDesc.ddpfPixelFormat.dwFourCC));
+    if (std::max(level.getWidth(), level.getHeight()) <= TEXTURE_TAIL_SIZE) return i;
   }
 
-  HTexture texture = Texture::create(desc);
+  return (UINT32)levels.levels.size();
+}
 
-  for (UINT32 i = 0; i < surfaceDesc.dwMipMapCount + 1; i++)
+/**
+ * The settings for uncompressed textures change what ends up in the cache, so they are part of
+ * the version of those. Block compressed textures are taken as they are and only get the version
+ * of the importer itself, so changing the settings does not make them outdated.
+ */
+static UINT32 textureImporterVersion(const std::vector<uint8_t>& ztexData)
+{
+  ZTEXHeader header;
+  if (!parseZTEXHeader(ztexData, header) || compressedPixelFormatOf(header) != PF_UNKNOWN)
   {
-    UINT32 mipWidth, mipHeight, mipDepth;
-    PixelUtil::getSizeForMipLevel(desc.width, desc.height, 1, i, mipWidth, mipHeight, mipDepth);
+    return TEXTURE_IMPORTER_VERSION;
+  }
 
-    SPtr<PixelData> pixelData = PixelData::create(mipWidth,   //
-                                                  mipHeight,  //
-                                                  mipDepth,   //
-                                                  desc.format);
+  TextureCompressionOptions compression = GetTextureCompression();
 
-    size_t mipOffset = ZenLoad::getMipFileOffsetFromDDS(ddsData, i);
+  // Starts at 1, so uncompressed textures never share the version of block compressed ones
+  UINT32 settings = (UINT32)s_MipFilter.load() + 1;
+  settings = settings * 8 + (UINT32)compression.compression;
 
-    UINT8* imageStart = (UINT8*)&ddsData[mipOffset];
+  if (compression.compression != TextureCompression::None)
+  {
+    settings = settings * 8 + (UINT32)compression.quality;
+  }
 
-    pixelData->setExternalBuffer(imageStart);
+  return TEXTURE_IMPORTER_VERSION + (settings << 16);
+}
 
-    texture->writeData(pixelData, 0, i);
-  }
+/**
+ * @return Whether the texture index lists the texture as built from the original data identified
+ *         by the given stamp, and the cached file is still there.
+ */
+static bool isCachedTextureUpToDate(const String& name, const CacheSourceStamp& stamp)
+{
+  CachedTextureInfo info;
+  if (!FindCachedTextureInfo(name, info)) return false;
 
-  texture->setName(name);
+  if (info.sourceHash != stamp.sourceHash) return false;
+  if (info.importerVersion != stamp.importerVersion) return false;
 
-  return texture;
+  return hasCachedTextureFile(name);
 }
 
-static std::vector<uint8_t> readCompiledTexture(const String& path, const VDFS::FileIndex& vdfs)
+/**
+ * Checks whether the cached file of a texture inside the texture index is known to the resource
+ * manifest or the cache pack. Both are kept in memory, so this does not touch the disk.
+ */
+static bool hasCachedTextureFile(const String& name)
 {
-  String compiledFile = path;
+  Path path = GothicPathToCachedTexture(name.c_str());
 
-  if (compiledFile.find(".TGA") != String::npos)
+  return HasCachedResource(path) || HasPackedResource(path);
+}
+
+static String compiledTextureName(const String& path)
+{
+  if (path.find(".TGA") != String::npos)
   {
-    compiledFile = replaceExtension(path, "-C.TEX");
+    return replaceExtension(path, "-C.TEX");
   }
 
+  return path;
+}
+
+static std::vector<uint8_t> readCompiledTexture(const String& path, const VDFS::FileIndex& vdfs)
+{
   std::vector<uint8_t> fileData;
-  vdfs.getFileData(compiledFile.c_str(), fileData);
+  readCompiledTexture(path, vdfs, fileData);
 
   return fileData;
 }
 
+/**
+ * Reads the compiled texture into the given buffer, keeping its capacity. Empty if there is no
+ * compiled texture.
+ */
+static void readCompiledTexture(const String& path, const VDFS::FileIndex& vdfs,
+                                std::vector<uint8_t>& outData)
+{
+  String compiledFile = compiledTextureName(path);
+
+  outData.clear();
+  vdfs.getFileData(compiledFile.c_str(), outData);
+}
+
 static String replaceExtension(const String& path, const String& newExtension)
 {
   // assert(path.length() >= 4);
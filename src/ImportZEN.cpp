@@ -6,9 +6,12 @@
  */
 
 #include "ImportZEN.hpp"
+#include "CachePack.hpp"
 #include "ImportPath.hpp"
 #include "ImportStaticMesh.hpp"
 #include "ResourceManifest.hpp"
+#include "TextureStreaming.hpp"
+#include "WorldChunks.hpp"
 #include <Components/BsCMeshCollider.h>
 #include <Components/BsCRenderable.h>
 #include <Debug/BsDebug.h>
@@ -28,8 +31,11 @@ using namespace BsZenLib::Res;
 
 static HSceneObject addWorldMesh(const bs::String& worldName, ZenLoad::ZenParser& zenParser,
                                  const VDFS::FileIndex& vdfs);
+static HSceneObject addWorldChunks(const bs::String& worldName, ZenLoad::ZenParser& zenParser,
+                                   const VDFS::FileIndex& vdfs);
 static HSceneObject addStaticMeshObject(const String& file, const VDFS::FileIndex& vdfs);
 static HSceneObject walkTree(const ZenLoad::zCVobData& root, const VDFS::FileIndex& vdfs);
+static void requestDetailRecursive(const HSceneObject& so, const Vector3& viewPosition);
 
 // - Implementation --------------------------------------------------------------------------------
 
@@ -61,7 +67,12 @@ bool BsZenLib::HasCachedZEN(const bs::String& zen)
 
 bs::HPrefab BsZenLib::LoadCachedZEN(const bs::String& zen)
 {
-  return gResources().loadAsync<Prefab>(GothicPathToCachedWorld(zen));
+  Path path = GothicPathToCachedWorld(zen);
+
+  // Nothing to wait for when reading from the mapped pack
+  if (HasPackedResource(path)) return static_resource_cast<Prefab>(LoadPackedResource(path));
+
+  return gResources().loadAsync<Prefab>(path);
 }
 
 bs::HSceneObject BsZenLib::ImportAndCacheZEN(const std::string& zen, const VDFS::FileIndex& vdfs)
@@ -112,12 +123,33 @@ HSceneObject BsZenLib::ImportZEN(const std::string& zen, const VDFS::FileIndex&
     vobs->setParent(worldSO);
   }
 
+  // Materials only reference the texture tails, so start streaming in the rest right away.
+  // The game should request again from the cameras position once it knows it.
+  if (IsTextureStreamingEnabled())
+  {
+    RequestWorldTextureDetail(worldSO, Vector3::ZERO);
+  }
+
   return worldSO;
 }
 
+void BsZenLib::RequestWorldTextureDetail(const bs::HSceneObject& world,
+                                         const bs::Vector3& viewPosition)
+{
+  requestDetailRecursive(world, viewPosition);
+}
+
 static HSceneObject addWorldMesh(const bs::String& worldName, ZenLoad::ZenParser& zenParser,
                                  const VDFS::FileIndex& vdfs)
 {
+  if (GetWorldChunkSize() > 0.0f)
+  {
+    HSceneObject chunksSO = addWorldChunks(worldName, zenParser, vdfs);
+
+    // Fall back to a single mesh if splitting failed
+    if (chunksSO) return chunksSO;
+  }
+
   String meshFileName = worldName + ".worldmesh";
 
   HMeshWithMaterials mesh;
@@ -164,6 +196,42 @@ static HSceneObject addWorldMesh(const bs::String& worldName, ZenLoad::ZenParser
   return meshSO;
 }
 
+/**
+ * Adds the world mesh split into chunks, splitting and caching it first if needed. The whole
+ * world mesh is cached along with the chunks, same as CacheWholeVDFS() does, so turning chunks
+ * off again does not need another import.
+ */
+static HSceneObject addWorldChunks(const bs::String& worldName, ZenLoad::ZenParser& zenParser,
+                                   const VDFS::FileIndex& vdfs)
+{
+  CacheSourceStamp stamp;
+  if (!MakeCacheSourceStamp(worldName, vdfs, GetStaticMeshImporterVersion(), stamp)) return {};
+
+  if (!HasCachedWorldChunks(worldName, stamp))
+  {
+    String meshFileName = worldName + ".worldmesh";
+
+    ZenLoad::PackedMesh packedMesh;
+    zenParser.getWorldMesh()->packMesh(packedMesh, 0.01f);
+
+    Vector<HMaterial> materials =
+        ImportAndCacheStaticMeshMaterials(meshFileName, packedMesh, vdfs);
+
+    if (!HasCachedResource(GothicPathToCachedStaticMesh(meshFileName), stamp))
+    {
+      ImportAndCacheStaticMesh(meshFileName, packedMesh, materials, stamp);
+    }
+
+    if (!ImportAndCacheWorldChunks(worldName, packedMesh, materials, stamp)) return {};
+  }
+
+  Vector<WorldChunk> chunks = LoadWorldChunkIndex(worldName);
+
+  if (chunks.empty()) return {};
+
+  return CreateWorldChunkObjects(worldName, chunks);
+}
+
 Matrix4 convertMatrix(const ZMath::Matrix& m)
 {
   Matrix4 bs = {m.mv[0], m.mv[1], m.mv[2],  m.mv[3],  m.mv[4],  m.mv[5],  m.mv[6],  m.mv[7],
@@ -228,3 +296,21 @@ static HSceneObject addStaticMeshObject(const String& file, const VDFS::FileInde
 
   return meshSO;
 }
+
+static void requestDetailRecursive(const HSceneObject& so, const Vector3& viewPosition)
+{
+  for (const HRenderable& renderable : so->getComponents<CRenderable>())
+  {
+    float distance = renderable->getBounds().getSphere().getCenter().distance(viewPosition);
+
+    for (const HMaterial& material : renderable->getMaterials())
+    {
+      RequestMaterialDetail(material, -distance);
+    }
+  }
+
+  for (UINT32 i = 0; i < so->getNumChildren(); i++)
+  {
+    requestDetailRecursive(so->getChild(i), viewPosition);
+  }
+}
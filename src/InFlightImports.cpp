@@ -0,0 +1,83 @@
+/**
+ * In-Flight Imports
+ * =================
+ *
+ * Every import currently running is put into a table, keyed by the path it will be cached at.
+ * The entry holds a future for the result of the import, which other threads wanting the same
+ * resource can wait on.
+ *
+ * Each thread also remembers which imports it is running itself, so nested imports of the same
+ * path (ie. loadOrCacheTexture() calling ImportAndCacheTexture()) don't wait on themselves.
+ */
+
+#include "InFlightImports.hpp"
+#include <future>
+#include <Threading/BsThreading.h>
+
+using namespace bs;
+
+static Mutex s_InFlightMutex;
+static UnorderedMap<String, std::shared_future<HResource>> s_InFlight;
+
+/**
+ * Imports started by the current thread which are still running.
+ */
+static thread_local UnorderedSet<String> s_ImportsOfThisThread;
+
+// - Implementation --------------------------------------------------------------------------------
+
+HResource BsZenLib::ImportOnce(const Path& cachePath, const std::function<HResource()>& import)
+{
+  String key = cachePath.toString();
+
+  if (s_ImportsOfThisThread.find(key) != s_ImportsOfThisThread.end())
+  {
+    return import();
+  }
+
+  std::promise<HResource> promise;
+
+  {
+    Lock lock(s_InFlightMutex);
+
+    auto it = s_InFlight.find(key);
+
+    if (it != s_InFlight.end())
+    {
+      std::shared_future<HResource> running = it->second;
+
+      lock.unlock();
+
+      return running.get();
+    }
+
+    s_InFlight[key] = promise.get_future().share();
+  }
+
+  s_ImportsOfThisThread.insert(key);
+
+  auto finish = [&]() {
+    s_ImportsOfThisThread.erase(key);
+
+    Lock lock(s_InFlightMutex);
+    s_InFlight.erase(key);
+  };
+
+  HResource imported;
+
+  try
+  {
+    imported = import();
+  }
+  catch (...)
+  {
+    finish();
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+
+  finish();
+  promise.set_value(imported);
+
+  return imported;
+}
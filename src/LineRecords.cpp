@@ -0,0 +1,261 @@
+/**
+ * Line Records
+ * ============
+ *
+ * Fields are written with a space after each of them, so a record ending with a text needs no
+ * special treatment. A record without text drops the last space again.
+ *
+ * Numbers are written and parsed through streams using the classic locale, so a locale set by
+ * the application can't change the format, ie. by using a decimal comma. Every field is cut out
+ * of its record before parsing it, so a missing field can't be taken from the next line. A field
+ * starting with whitespace is rejected, as the streams would skip over it.
+ */
+
+#include "LineRecords.hpp"
+#include <iomanip>
+#include <locale>
+#include <FileSystem/BsDataStream.h>
+#include <FileSystem/BsFileSystem.h>
+
+using namespace bs;
+using namespace BsZenLib;
+
+static bool isFieldStart(const char* cursor, const char* recordEnd);
+static const char* findFieldEnd(const char* cursor, const char* recordEnd);
+
+template <typename T>
+static void writeNumber(T value, int precision, String& outContents);
+
+template <typename T>
+static bool parseNumber(const char* fieldStart, const char* fieldEnd, T& outValue);
+
+// - Implementation --------------------------------------------------------------------------------
+
+void LineRecordWriter::write(UINT64 value)
+{
+  writeNumber(value, 0, mContents);
+}
+
+void LineRecordWriter::write(UINT32 value)
+{
+  writeNumber(value, 0, mContents);
+}
+
+void LineRecordWriter::write(float value)
+{
+  // Enough digits for floats to survive the round trip
+  writeNumber(value, 9, mContents);
+}
+
+void LineRecordWriter::write(const String& word)
+{
+  mContents += word;
+  mContents += ' ';
+}
+
+void LineRecordWriter::endRecord(const String& text)
+{
+  if (text.empty() && !mContents.empty() && mContents.back() == ' ')
+  {
+    mContents.pop_back();
+  }
+
+  mContents += text;
+  mContents += '\n';
+}
+
+bool LineRecordWriter::save(const Path& path) const
+{
+  SPtr<DataStream> stream = FileSystem::createAndOpenFile(path);
+
+  if (!stream) return false;
+
+  stream->writeString(mContents);
+  stream->close();
+
+  return true;
+}
+
+bool LineRecordAppender::append(const Path& path, const LineRecordWriter& records)
+{
+  if (!mFile.is_open())
+  {
+    FileSystem::createDir(path.getDirectory());
+
+    mFile.open(path.toPlatformString().c_str(), std::ios::out | std::ios::app | std::ios::binary);
+
+    if (!mFile.is_open()) return false;
+  }
+
+  mFile << records.getContents();
+  mFile.flush();
+
+  return true;
+}
+
+void LineRecordAppender::close()
+{
+  if (mFile.is_open()) mFile.close();
+}
+
+bool LineRecordReader::open(const Path& path)
+{
+  mContents.clear();
+  mNextLine = 0;
+  mCursor = nullptr;
+  mRecordEnd = nullptr;
+
+  if (!FileSystem::isFile(path)) return false;
+
+  SPtr<DataStream> stream = FileSystem::openFile(path);
+
+  if (!stream) return false;
+
+  mContents = stream->getAsString();
+  stream->close();
+
+  return true;
+}
+
+bool LineRecordReader::nextRecord()
+{
+  size_t lineEnd = mContents.find('\n', mNextLine);
+
+  if (lineEnd == String::npos) return false;
+
+  mCursor = mContents.data() + mNextLine;
+  mRecordEnd = mContents.data() + lineEnd;
+  mNextLine = lineEnd + 1;
+
+  return true;
+}
+
+bool LineRecordReader::read(UINT64& outValue)
+{
+  if (!isFieldStart(mCursor, mRecordEnd)) return false;
+
+  const char* end = findFieldEnd(mCursor, mRecordEnd);
+  UINT64 value;
+
+  if (!parseNumber(mCursor, end, value) || !skipField(end)) return false;
+
+  outValue = value;
+
+  return true;
+}
+
+bool LineRecordReader::read(UINT32& outValue)
+{
+  UINT64 value;
+
+  if (!read(value)) return false;
+
+  outValue = (UINT32)value;
+
+  return true;
+}
+
+bool LineRecordReader::read(float& outValue)
+{
+  if (!isFieldStart(mCursor, mRecordEnd)) return false;
+
+  const char* end = findFieldEnd(mCursor, mRecordEnd);
+  float value;
+
+  if (!parseNumber(mCursor, end, value) || !skipField(end)) return false;
+
+  outValue = value;
+
+  return true;
+}
+
+bool LineRecordReader::read(String& outWord)
+{
+  if (!isFieldStart(mCursor, mRecordEnd)) return false;
+
+  const char* end = findFieldEnd(mCursor, mRecordEnd);
+
+  outWord.assign(mCursor, end);
+
+  return skipField(end);
+}
+
+String LineRecordReader::readRest()
+{
+  if (!mCursor) return "";
+
+  String rest(mCursor, mRecordEnd);
+  StringUtil::trim(rest);
+
+  mCursor = mRecordEnd;
+
+  return rest;
+}
+
+bool LineRecordReader::skipField(const char* fieldEnd)
+{
+  if (fieldEnd == mRecordEnd || *fieldEnd == '\r')
+  {
+    mCursor = mRecordEnd;
+    return true;
+  }
+
+  if (fieldEnd > mRecordEnd || *fieldEnd != ' ') return false;
+
+  mCursor = fieldEnd + 1;
+
+  return true;
+}
+
+static bool isFieldStart(const char* cursor, const char* recordEnd)
+{
+  if (!cursor || cursor >= recordEnd) return false;
+
+  return *cursor != ' ' && *cursor != '\t' && *cursor != '\r';
+}
+
+/**
+ * @return End of the field starting at the cursor, ie. the space following it.
+ */
+static const char* findFieldEnd(const char* cursor, const char* recordEnd)
+{
+  const char* end = cursor;
+
+  while (end < recordEnd && *end != ' ' && *end != '\r')
+  {
+    end++;
+  }
+
+  return end;
+}
+
+/**
+ * @param precision  Significant digits to write, 0 for the default of the stream.
+ */
+template <typename T>
+static void writeNumber(T value, int precision, String& outContents)
+{
+  StringStream field;
+  field.imbue(std::locale::classic());
+
+  if (precision > 0) field << std::setprecision(precision);
+
+  field << value;
+
+  outContents += field.str();
+  outContents += ' ';
+}
+
+/**
+ * @return False, if the field is not a number as a whole.
+ */
+template <typename T>
+static bool parseNumber(const char* fieldStart, const char* fieldEnd, T& outValue)
+{
+  StringStream field(String(fieldStart, fieldEnd));
+  field.imbue(std::locale::classic());
+
+  field >> outValue;
+
+  return !field.fail() && field.peek() == StringStream::traits_type::eof();
+}
@@ -0,0 +1,48 @@
+/**
+ * Mesh Indices
+ * ============
+ *
+ * SSE2 has no instruction to pack unsigned 32-bit integers into unsigned 16-bit ones, only a
+ * signed one which saturates. As all indices are below 65536, shifting them up and arithmetically
+ * down by 16 bits turns them into the signed 16-bit values with the same bit pattern, which then
+ * pack without saturating.
+ */
+
+#include "MeshIndices.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BSZENLIB_SSE2_INDICES 1
+#include <emmintrin.h>
+#endif
+
+using namespace bs;
+
+// - Implementation --------------------------------------------------------------------------------
+
+IndexType BsZenLib::ChooseIndexType(UINT32 numVertices)
+{
+  return numVertices < 0x10000 ? IT_16BIT : IT_32BIT;
+}
+
+void BsZenLib::NarrowIndices(const UINT32* src, UINT16* dst, size_t count)
+{
+  size_t i = 0;
+
+#if BSZENLIB_SSE2_INDICES
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i low = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i high = _mm_loadu_si128((const __m128i*)(src + i + 4));
+
+    low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+    high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(low, high));
+  }
+#endif
+
+  for (; i < count; i++)
+  {
+    dst[i] = (UINT16)src[i];
+  }
+}
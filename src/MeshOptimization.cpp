@@ -0,0 +1,320 @@
+/**
+ * Mesh Optimization
+ * =================
+ *
+ * The vertex cache optimization follows Tom Forsyth's "Linear-Speed Vertex Cache Optimisation":
+ * Every vertex gets a score from its position inside a simulated LRU cache and from how many
+ * triangles still use it. The triangle with the highest sum of vertex scores is emitted next.
+ * Only triangles of vertices whose score changed are looked at again, which keeps it linear.
+ * If none of those are left, the next triangle not emitted yet in the original order is used.
+ *
+ * Submeshes only use a part of the vertices of a mesh, ie. a world mesh has hundreds of
+ * submeshes sharing one vertex buffer. Each submesh is therefore optimized with its vertices
+ * renumbered to a compact local range, so the per-vertex state stays small.
+ */
+
+#include "MeshOptimization.hpp"
+#include "ParallelFor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <zenload/zTypes.h>
+
+using namespace bs;
+using namespace BsZenLib;
+
+/**
+ * Size of the LRU cache used for scoring vertices. Larger than ACMR_CACHE_SIZE, as Forsyth
+ * recommends: The exact size of the real cache matters little.
+ */
+static constexpr UINT32 SCORING_CACHE_SIZE = 32;
+
+// Scoring parameters as suggested by Forsyth
+static constexpr float CACHE_DECAY_POWER = 1.5f;
+static constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+static constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+static constexpr UINT32 NO_TRIANGLE = ~0u;
+static constexpr UINT32 NOT_REMAPPED = ~0u;
+
+static void optimizeSubmeshVertexCache(std::vector<uint32_t>& indices);
+static float vertexScore(INT32 cachePosition, UINT32 remainingTriangles);
+
+// - Implementation --------------------------------------------------------------------------------
+
+float BsZenLib::ComputeACMR(const ZenLoad::PackedMesh& packedMesh, UINT32 cacheSize)
+{
+  // A vertex is inside the FIFO cache if less than `cacheSize` misses happened since it was
+  // put there. Starting ahead of all vertices makes the cache start out empty.
+  Vector<UINT32> cachedAt(packedMesh.vertices.size(), 0);
+  UINT32 time = cacheSize + 1;
+
+  UINT64 numMisses = 0;
+  UINT64 numTriangles = 0;
+
+  for (const auto& submesh : packedMesh.subMeshes)
+  {
+    for (uint32_t index : submesh.indices)
+    {
+      if (time - cachedAt[index] <= cacheSize) continue;
+
+      cachedAt[index] = time;
+      time++;
+      numMisses++;
+    }
+
+    numTriangles += submesh.indices.size() / 3;
+
+    // Flush the cache between draw calls
+    time += cacheSize;
+  }
+
+  if (numTriangles == 0) return 0.0f;
+
+  return (float)((double)numMisses / (double)numTriangles);
+}
+
+void BsZenLib::OptimizeVertexCache(ZenLoad::PackedMesh& packedMesh)
+{
+  ParallelFor((UINT32)packedMesh.subMeshes.size(), 1, [&](UINT32 first, UINT32 last) {
+    for (UINT32 i = first; i < last; i++)
+    {
+      optimizeSubmeshVertexCache(packedMesh.subMeshes[i].indices);
+    }
+  });
+}
+
+void BsZenLib::OptimizeVertexFetch(ZenLoad::PackedMesh& packedMesh)
+{
+  const size_t numVertices = packedMesh.vertices.size();
+
+  Vector<UINT32> remap(numVertices, NOT_REMAPPED);
+  UINT32 nextVertex = 0;
+
+  for (auto& submesh : packedMesh.subMeshes)
+  {
+    for (uint32_t& index : submesh.indices)
+    {
+      if (remap[index] == NOT_REMAPPED)
+      {
+        remap[index] = nextVertex++;
+      }
+
+      index = remap[index];
+    }
+  }
+
+  for (UINT32& newIndex : remap)
+  {
+    if (newIndex == NOT_REMAPPED)
+    {
+      newIndex = nextVertex++;
+    }
+  }
+
+  decltype(packedMesh.vertices) reordered(numVertices);
+
+  for (size_t i = 0; i < numVertices; i++)
+  {
+    reordered[remap[i]] = packedMesh.vertices[i];
+  }
+
+  packedMesh.vertices.swap(reordered);
+}
+
+static void optimizeSubmeshVertexCache(std::vector<uint32_t>& indices)
+{
+  const UINT32 numTriangles = (UINT32)(indices.size() / 3);
+
+  if (numTriangles < 2) return;
+
+  // Renumber the vertices used by this submesh to [0, numLocal)
+  Vector<UINT32> usedVertices(indices.begin(), indices.begin() + numTriangles * 3);
+  std::sort(usedVertices.begin(), usedVertices.end());
+  usedVertices.erase(std::unique(usedVertices.begin(), usedVertices.end()), usedVertices.end());
+
+  const UINT32 numLocal = (UINT32)usedVertices.size();
+
+  Vector<UINT32> localIndices(numTriangles * 3);
+
+  for (size_t i = 0; i < localIndices.size(); i++)
+  {
+    localIndices[i] = (UINT32)(std::lower_bound(usedVertices.begin(), usedVertices.end(),
+                                                indices[i]) -
+                               usedVertices.begin());
+  }
+
+  // Triangles using each vertex. Emitted triangles are swapped out of the range of a vertex,
+  // so the first `remaining[v]` entries starting at `firstTriangle[v]` are the ones left.
+  Vector<UINT32> remaining(numLocal, 0);
+  Vector<UINT32> firstTriangle(numLocal + 1, 0);
+  Vector<UINT32> vertexTriangles(numTriangles * 3);
+
+  for (UINT32 local : localIndices)
+  {
+    remaining[local]++;
+  }
+
+  for (UINT32 v = 0; v < numLocal; v++)
+  {
+    firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+  }
+
+  {
+    Vector<UINT32> filled(numLocal, 0);
+
+    for (UINT32 i = 0; i < numTriangles * 3; i++)
+    {
+      UINT32 v = localIndices[i];
+      vertexTriangles[firstTriangle[v] + filled[v]++] = i / 3;
+    }
+  }
+
+  Vector<INT32> cachePosition(numLocal, -1);
+  Vector<float> vertexScores(numLocal);
+  Vector<float> triangleScores(numTriangles, 0.0f);
+  Vector<UINT8> isEmitted(numTriangles, 0);
+
+  for (UINT32 v = 0; v < numLocal; v++)
+  {
+    vertexScores[v] = vertexScore(-1, remaining[v]);
+  }
+
+  for (UINT32 t = 0; t < numTriangles; t++)
+  {
+    for (UINT32 k = 0; k < 3; k++)
+    {
+      triangleScores[t] += vertexScores[localIndices[t * 3 + k]];
+    }
+  }
+
+  // Three more than the cache holds, for the vertices pushed out by the last triangle
+  UINT32 cache[SCORING_CACHE_SIZE + 3];
+  UINT32 cacheCount = 0;
+
+  std::vector<uint32_t> optimized;
+  optimized.reserve(numTriangles * 3);
+
+  UINT32 bestTriangle = 0;
+  UINT32 nextUnemitted = 0;
+
+  for (UINT32 numEmitted = 0; numEmitted < numTriangles; numEmitted++)
+  {
+    if (bestTriangle == NO_TRIANGLE)
+    {
+      while (isEmitted[nextUnemitted])
+      {
+        nextUnemitted++;
+      }
+
+      bestTriangle = nextUnemitted;
+    }
+
+    const UINT32 emitted = bestTriangle;
+    const UINT32* triangle = &localIndices[emitted * 3];
+
+    isEmitted[emitted] = 1;
+
+    for (UINT32 k = 0; k < 3; k++)
+    {
+      optimized.push_back(indices[emitted * 3 + k]);
+
+      UINT32 v = triangle[k];
+      UINT32* begin = &vertexTriangles[firstTriangle[v]];
+      UINT32* end = begin + remaining[v];
+
+      std::swap(*std::find(begin, end, emitted), *(end - 1));
+      remaining[v]--;
+    }
+
+    // Move the vertices of the triangle to the front of the cache
+    UINT32 newCache[SCORING_CACHE_SIZE + 3];
+    UINT32 newCount = 0;
+
+    for (UINT32 k = 0; k < 3; k++)
+    {
+      newCache[newCount++] = triangle[k];
+    }
+
+    for (UINT32 i = 0; i < cacheCount; i++)
+    {
+      UINT32 v = cache[i];
+
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+      {
+        newCache[newCount++] = v;
+      }
+    }
+
+    // Rescore everything that was or is inside the cache, including what just fell out of it
+    for (UINT32 i = 0; i < newCount; i++)
+    {
+      UINT32 v = newCache[i];
+
+      cachePosition[v] = i < SCORING_CACHE_SIZE ? (INT32)i : -1;
+      vertexScores[v] = vertexScore(cachePosition[v], remaining[v]);
+    }
+
+    bestTriangle = NO_TRIANGLE;
+    float bestScore = -1.0f;
+
+    for (UINT32 i = 0; i < newCount; i++)
+    {
+      UINT32 v = newCache[i];
+
+      for (UINT32 j = 0; j < remaining[v]; j++)
+      {
+        UINT32 t = vertexTriangles[firstTriangle[v] + j];
+        const UINT32* other = &localIndices[t * 3];
+
+        triangleScores[t] =
+            vertexScores[other[0]] + vertexScores[other[1]] + vertexScores[other[2]];
+
+        if (triangleScores[t] > bestScore)
+        {
+          bestScore = triangleScores[t];
+          bestTriangle = t;
+        }
+      }
+    }
+
+    cacheCount = std::min(newCount, SCORING_CACHE_SIZE);
+    std::copy(newCache, newCache + cacheCount, cache);
+  }
+
+  // Keep a trailing partial triangle, should there be one
+  optimized.insert(optimized.end(), indices.begin() + numTriangles * 3, indices.end());
+
+  indices.swap(optimized);
+}
+
+/**
+ * @param cachePosition       Position inside the LRU cache, -1 if not inside.
+ * @param remainingTriangles  Triangles using the vertex which have not been emitted yet.
+ */
+static float vertexScore(INT32 cachePosition, UINT32 remainingTriangles)
+{
+  if (remainingTriangles == 0) return -1.0f;
+
+  float score = 0.0f;
+
+  if (cachePosition >= 0)
+  {
+    if (cachePosition < 3)
+    {
+      // Vertices of the last triangle get a fixed, slightly lower score, so the next triangle
+      // does not always just continue from the edge last added
+      score = LAST_TRIANGLE_SCORE;
+    }
+    else
+    {
+      const float scale = 1.0f / (SCORING_CACHE_SIZE - 3);
+      score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+    }
+  }
+
+  // Prefer vertices with few triangles left, to get rid of lone triangles early
+  score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+
+  return score;
+}
@@ -0,0 +1,204 @@
+/**
+ * Mesh Tangents
+ * =============
+ *
+ * Generating tangents is split into three steps:
+ *
+ *  1. For every submesh in parallel, compute the tangent and bitangent of each triangle from
+ *     the differences of its positions and texture coordinates, and weight them by the angle
+ *     at each of its corners. Those go into an array per submesh, so nothing is shared.
+ *  2. Add up the weighted directions of all corners referencing the same vertex. Submeshes may
+ *     share vertices, so this is done on a single thread. It's only additions.
+ *  3. For ranges of vertices in parallel, make the tangent orthogonal to the normal and derive
+ *     the handedness from the bitangent.
+ *
+ * Triangles without usable texture coordinates don't contribute. Vertices left without any
+ * tangent get an arbitrary one orthogonal to their normal.
+ */
+
+#include "MeshTangents.hpp"
+#include "ParallelFor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <Resources/BsBuiltinResources.h>
+#include <zenload/zTypes.h>
+
+using namespace bs;
+using namespace BsZenLib;
+
+/**
+ * Vertices to finalize in one task.
+ */
+static constexpr UINT32 MIN_VERTICES_PER_TASK = 16 * 1024;
+
+/**
+ * Texture coordinates spanning less area than this are considered degenerate.
+ */
+static constexpr float MIN_UV_AREA = 1e-12f;
+
+/**
+ * Weighted tangent and bitangent one corner of a triangle contributes to its vertex.
+ */
+struct CornerTangents
+{
+  Vector3 tangent;
+  Vector3 bitangent;
+};
+
+static void computeCornerTangents(const ZenLoad::PackedMesh& packedMesh, UINT32 submesh,
+                                  Vector<CornerTangents>& outCorners);
+static Vector4 finalizeTangent(const Vector3& normal, const Vector3& tangent,
+                               const Vector3& bitangent);
+static Vector3 normalized(const Vector3& v);
+static float angleBetween(const Vector3& a, const Vector3& b);
+
+// - Implementation --------------------------------------------------------------------------------
+
+bool BsZenLib::MaterialNeedsTangents(const HMaterial& material)
+{
+  if (!material) return false;
+
+  HShader shader = material->getShader();
+
+  if (!shader || !shader->hasTextureParam(NORMAL_MAP_PARAM)) return false;
+
+  HTexture normalMap = material->getTexture(NORMAL_MAP_PARAM);
+
+  if (!normalMap) return false;
+
+  return normalMap != gBuiltinResources().getTexture(BuiltinTexture::Normal);
+}
+
+void BsZenLib::GenerateTangents(const ZenLoad::PackedMesh& packedMesh,
+                                Vector<Vector4>& outTangents)
+{
+  const UINT32 numVertices = (UINT32)packedMesh.vertices.size();
+  const UINT32 numSubmeshes = (UINT32)packedMesh.subMeshes.size();
+
+  // 1. Every submesh on its own
+  Vector<Vector<CornerTangents>> corners(numSubmeshes);
+
+  ParallelFor(numSubmeshes, 1, [&](UINT32 first, UINT32 last) {
+    for (UINT32 i = first; i < last; i++)
+    {
+      computeCornerTangents(packedMesh, i, corners[i]);
+    }
+  });
+
+  // 2. Sum up per vertex
+  Vector<CornerTangents> sums(numVertices, CornerTangents{Vector3::ZERO, Vector3::ZERO});
+
+  for (UINT32 i = 0; i < numSubmeshes; i++)
+  {
+    const auto& indices = packedMesh.subMeshes[i].indices;
+
+    for (size_t corner = 0; corner < corners[i].size(); corner++)
+    {
+      CornerTangents& sum = sums[indices[corner]];
+
+      sum.tangent += corners[i][corner].tangent;
+      sum.bitangent += corners[i][corner].bitangent;
+    }
+  }
+
+  // 3. Orthogonalize
+  outTangents.resize(numVertices);
+
+  ParallelFor(numVertices, MIN_VERTICES_PER_TASK, [&](UINT32 first, UINT32 last) {
+    for (UINT32 i = first; i < last; i++)
+    {
+      const auto& n = packedMesh.vertices[i].Normal;
+
+      outTangents[i] = finalizeTangent(Vector3(n.x, n.y, n.z), sums[i].tangent,
+                                       sums[i].bitangent);
+    }
+  });
+}
+
+/**
+ * Computes what every corner of the triangles of the given submesh contributes, in the order of
+ * its indices.
+ */
+static void computeCornerTangents(const ZenLoad::PackedMesh& packedMesh, UINT32 submesh,
+                                  Vector<CornerTangents>& outCorners)
+{
+  const auto& vertices = packedMesh.vertices;
+  const auto& indices = packedMesh.subMeshes[submesh].indices;
+
+  outCorners.assign(indices.size(), CornerTangents{Vector3::ZERO, Vector3::ZERO});
+
+  for (size_t triangle = 0; triangle + 2 < indices.size(); triangle += 3)
+  {
+    Vector3 positions[3];
+    Vector2 uvs[3];
+
+    for (UINT32 i = 0; i < 3; i++)
+    {
+      const ZenLoad::WorldVertex& vertex = vertices[indices[triangle + i]];
+
+      positions[i] = Vector3(vertex.Position.x, vertex.Position.y, vertex.Position.z);
+      uvs[i] = Vector2(vertex.TexCoord.x, vertex.TexCoord.y);
+    }
+
+    Vector3 edge1 = positions[1] - positions[0];
+    Vector3 edge2 = positions[2] - positions[0];
+    Vector2 deltaUV1 = uvs[1] - uvs[0];
+    Vector2 deltaUV2 = uvs[2] - uvs[0];
+
+    float uvArea = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+
+    if (std::abs(uvArea) < MIN_UV_AREA) continue;
+
+    // Only the directions matter, the scale comes from the corner angles below
+    Vector3 tangent = normalized((edge1 * deltaUV2.y - edge2 * deltaUV1.y) * (1.0f / uvArea));
+    Vector3 bitangent = normalized((edge2 * deltaUV1.x - edge1 * deltaUV2.x) * (1.0f / uvArea));
+
+    for (UINT32 i = 0; i < 3; i++)
+    {
+      const Vector3& corner = positions[i];
+      float angle = angleBetween(positions[(i + 1) % 3] - corner, positions[(i + 2) % 3] - corner);
+
+      outCorners[triangle + i].tangent = tangent * angle;
+      outCorners[triangle + i].bitangent = bitangent * angle;
+    }
+  }
+}
+
+static Vector4 finalizeTangent(const Vector3& normal, const Vector3& tangent,
+                               const Vector3& bitangent)
+{
+  Vector3 n = normalized(normal);
+
+  // Gram-Schmidt
+  Vector3 t = normalized(tangent - n * n.dot(tangent));
+
+  if (t == Vector3::ZERO)
+  {
+    // No usable texture coordinates, any direction orthogonal to the normal will do
+    Vector3 axis = std::abs(n.x) < 0.9f ? Vector3::UNIT_X : Vector3::UNIT_Y;
+    t = normalized(n.cross(axis));
+  }
+
+  float handedness = n.cross(t).dot(bitangent) < 0.0f ? -1.0f : 1.0f;
+
+  return Vector4(t.x, t.y, t.z, handedness);
+}
+
+/**
+ * @return The given vector with a length of 1, or zero if it is too short to tell a direction.
+ */
+static Vector3 normalized(const Vector3& v)
+{
+  float length = v.length();
+
+  if (length < 1e-8f) return Vector3::ZERO;
+
+  return v * (1.0f / length);
+}
+
+static float angleBetween(const Vector3& a, const Vector3& b)
+{
+  float cosine = normalized(a).dot(normalized(b));
+
+  return std::acos(std::min(std::max(cosine, -1.0f), 1.0f));
+}
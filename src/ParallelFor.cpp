@@ -0,0 +1,48 @@
+/**
+ * Parallel For
+ * ============
+ *
+ * One task is created per range. The ranges are expected to be large, so there is no need for
+ * anything like work stealing.
+ */
+
+#include "ParallelFor.hpp"
+#include <algorithm>
+#include <Threading/BsTaskScheduler.h>
+
+using namespace bs;
+using namespace BsZenLib;
+
+// - Implementation --------------------------------------------------------------------------------
+
+void BsZenLib::ParallelFor(bs::UINT32 count, bs::UINT32 minPerRange,
+                           const std::function<void(bs::UINT32, bs::UINT32)>& work)
+{
+  UINT32 perRange = std::max(1u, minPerRange);
+
+  if (perRange >= count)
+  {
+    if (count > 0) work(0, count);
+    return;
+  }
+
+  Vector<SPtr<Task>> tasks;
+
+  for (UINT32 first = perRange; first < count; first += perRange)
+  {
+    UINT32 last = std::min(count, first + perRange);
+
+    SPtr<Task> task = Task::create("BsZenLib::ParallelFor",
+                                   [&work, first, last]() { work(first, last); });
+
+    TaskScheduler::instance().addTask(task);
+    tasks.push_back(task);
+  }
+
+  work(0, perRange);
+
+  for (const SPtr<Task>& task : tasks)
+  {
+    task->wait();
+  }
+}
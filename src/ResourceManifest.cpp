@@ -1,62 +1,752 @@
+/**
+ * Resource Manifest
+ * =================
+ *
+ * The gothic-cache manifest is populated from many import tasks at once (see CacheWholeVDFS()),
+ * so registrations do not go into the bs::f manifest directly, which is not threadsafe.
+ *
+ * Instead, they are collected in a set of shards, each guarded by its own mutex, so tasks
+ * registering different files rarely contend. Alongside, the hash of every registered path is
+ * put into a lock-free hash set, which is what HasCachedResource() looks at together with the
+ * manifest loaded from disk. The loaded manifest is never modified until the shards are flushed
+ * into it by SaveResourceManifest(), so reading from it does not need a lock either.
+ *
+ * bs::f manifests only map UUIDs to paths. To know which original data a cached resource was
+ * built from, a CacheSourceStamp can be registered along with it. Those are written next to the
+ * manifest into a plain text file `gothic-cache.stamps`, one `<hash> <version> <path>` per line.
+ *
+ * Saving the manifest rewrites it completely, which is too slow to do after every import. So
+ * that a crash does not lose everything imported since the last save, each registration is also
+ * appended to `gothic-cache.journal`, one `<uuid> <hash> <version> <path>` per line (hash and
+ * version are `-` if there is no stamp). Lines are collected per shard and written in batches of
+ * JOURNAL_BATCH_RECORDS, so a crash loses at most JOURNAL_BATCH_RECORDS - 1 registrations per
+ * shard, 192 in total. FlushResourceManifestJournal() writes what is left before the process
+ * exits, SaveResourceManifest() makes it unnecessary. Loading the manifest replays
+ * the journal on top of it. SaveResourceManifest() compacts it: once manifest and stamps are
+ * written, the journal is emptied. A line cut off by a crash is missing its line break and is
+ * ignored.
+ */
+
 #include "ResourceManifest.hpp"
+#include <atomic>
 #include <Resources/BsResource.h>
+#include "ImportMetrics.hpp"
 #include "ImportPath.hpp"
+#include "LineRecords.hpp"
 #include <FileSystem/BsFileSystem.h>
 #include <Resources/BsResourceManifest.h>
 #include <Resources/BsResources.h>
+#include <Threading/BsThreading.h>
+#include <vdfs/fileIndex.h>
+
+using namespace bs;
 
 constexpr auto GOTHIC_CACHE_MANIFEST_NAME = "gothic-cache";
+constexpr auto GOTHIC_CACHE_STAMPS_FILE = "gothic-cache.stamps";
+constexpr auto GOTHIC_CACHE_JOURNAL_FILE = "gothic-cache.journal";
+
+/**
+ * Number of shards pending registrations are spread across. Should be well above the number of
+ * worker threads so two tasks rarely hit the same one.
+ */
+constexpr UINT32 NUM_MANIFEST_SHARDS = 64;
+
+/**
+ * Initial number of slots of the lock-free path set. A full Gothic II cache registers
+ * about 50k resources, which fits without needing to grow.
+ */
+constexpr UINT32 INITIAL_PATH_SET_CAPACITY = 1 << 17;
+
+/**
+ * Journal lines a shard collects before writing them. Kept small, as that many registrations
+ * per shard minus one are lost if the process crashes.
+ */
+constexpr UINT32 JOURNAL_BATCH_RECORDS = 4;
+
+namespace
+{
+  /**
+   * Lock-free, insert-only set of 64-bit hashes.
+   *
+   * Uses open addressing with linear probing. Once a table gets half full, a new table of twice
+   * the size is put in front of it. Old tables are kept around, so lookups have to go through
+   * all of them, which is fine since there are only ever a few.
+   */
+  class ConcurrentHashSet
+  {
+  public:
+    ConcurrentHashSet(UINT32 initialCapacity) { mHead = new Table(initialCapacity, nullptr); }
+
+    ~ConcurrentHashSet()
+    {
+      Table* table = mHead.load();
+
+      while (table)
+      {
+        Table* next = table->next;
+        delete table;
+        table = next;
+      }
+    }
+
+    bool contains(UINT64 hash) const
+    {
+      hash = sanitize(hash);
+
+      for (Table* t = mHead.load(std::memory_order_acquire); t; t = t->next)
+      {
+        if (t->contains(hash)) return true;
+      }
+
+      return false;
+    }
+
+    void insert(UINT64 hash)
+    {
+      hash = sanitize(hash);
+
+      if (contains(hash)) return;
+
+      while (true)
+      {
+        Table* head = mHead.load(std::memory_order_acquire);
+
+        if (head->tryInsert(hash)) return;
+
+        grow(head);
+      }
+    }
+
+  private:
+    struct Table
+    {
+      Table(UINT32 capacity, Table* next)
+          : mask(capacity - 1)
+          , slots(new std::atomic<UINT64>[capacity])
+          , next(next)
+      {
+        for (UINT32 i = 0; i < capacity; i++)
+        {
+          slots[i].store(0, std::memory_order_relaxed);
+        }
+      }
+
+      ~Table() { delete[] slots; }
+
+      bool contains(UINT64 hash) const
+      {
+        for (UINT32 i = (UINT32)hash & mask;; i = (i + 1) & mask)
+        {
+          UINT64 value = slots[i].load(std::memory_order_acquire);
+
+          if (value == hash) return true;
+          if (value == 0) return false;
+        }
+      }
 
-static bs::SPtr<bs::ResourceManifest> s_GothicCache;
+      /**
+       * @return False, if the table is too full to take the value.
+       */
+      bool tryInsert(UINT64 hash)
+      {
+        if (size.fetch_add(1, std::memory_order_relaxed) >= (mask + 1) / 2)
+        {
+          size.fetch_sub(1, std::memory_order_relaxed);
+          return false;
+        }
+
+        for (UINT32 i = (UINT32)hash & mask;; i = (i + 1) & mask)
+        {
+          UINT64 expected = 0;
+
+          if (slots[i].compare_exchange_strong(expected, hash, std::memory_order_acq_rel))
+          {
+            return true;
+          }
+
+          if (expected == hash)
+          {
+            // Someone else was faster inserting the same value
+            size.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+          }
+        }
+      }
+
+      UINT32 mask;
+      std::atomic<UINT64>* slots;
+      std::atomic<UINT32> size{0};
+      Table* next;
+    };
+
+    void grow(Table* full)
+    {
+      Lock lock(mGrowMutex);
+
+      // Someone else might have grown the set while we were waiting
+      if (mHead.load(std::memory_order_acquire) != full) return;
+
+      mHead.store(new Table((full->mask + 1) * 2, full), std::memory_order_release);
+    }
+
+    /**
+     * 0 marks an empty slot, so it can't be stored.
+     */
+    static UINT64 sanitize(UINT64 hash) { return hash == 0 ? 1 : hash; }
+
+    std::atomic<Table*> mHead;
+    Mutex mGrowMutex;
+  };
+
+  /**
+   * Registrations which have not been flushed into the manifest yet.
+   */
+  struct PendingEntry
+  {
+    UUID uuid;
+    BsZenLib::CacheSourceStamp stamp;
+    bool hasStamp = false;
+  };
+
+  struct ManifestShard
+  {
+    Mutex mutex;
+    Map<String, PendingEntry> pending;
+
+    /** Journal lines of registrations not written yet */
+    LineRecordWriter journal;
+    UINT32 numJournalRecords = 0;
+  };
+}  // namespace
+
+static SPtr<ResourceManifest> s_GothicCache;
+static std::atomic<bool> s_IsGothicCacheLoaded{false};
+static Mutex s_LoadMutex;
+
+static ManifestShard s_Shards[NUM_MANIFEST_SHARDS];
+static ConcurrentHashSet s_RegisteredPaths(INITIAL_PATH_SET_CAPACITY);
+
+/**
+ * Stamps of flushed registrations. Like the manifest, this is only modified while flushing.
+ */
+static Map<String, BsZenLib::CacheSourceStamp> s_Stamps;
+
+/**
+ * Journal registrations are appended to. Opened on the first registration after loading or
+ * compacting.
+ */
+static Mutex s_JournalMutex;
+static LineRecordAppender s_Journal;
+
+static void ensureManifestLoaded();
+static void registerPending(const Path& filePath, const PendingEntry& entry);
+static UINT64 hashPath(const String& path);
+static void loadResourceManifestLocked();
+static Path stampsFilePath();
+static void loadStamps();
+static void saveStamps();
+static Path journalFilePath();
+static void writeJournalRecord(const String& key, const PendingEntry& entry,
+                               LineRecordWriter& records);
+static void writeToJournal(const LineRecordWriter& records);
+static UINT32 replayJournal();
+static void flushPendingAndSave();
+static void clearJournal();
+
+// - Implementation --------------------------------------------------------------------------------
 
 namespace BsZenLib
 {
   void LoadResourceManifest()
   {
-    bs::Path manifestPath = BsZenLib::GothicPathToCachedManifest(GOTHIC_CACHE_MANIFEST_NAME);
+    Lock lock(s_LoadMutex);
+
+    loadResourceManifestLocked();
+  }
+
+  void AddToResourceManifest(bs::HResource resource, const bs::Path& filePath)
+  {
+    PendingEntry entry;
+    entry.uuid = resource.getUUID();
+
+    registerPending(filePath, entry);
+  }
 
-    if (bs::FileSystem::exists(manifestPath))
+  void AddToResourceManifest(bs::HResource resource, const bs::Path& filePath,
+                             const CacheSourceStamp& stamp)
+  {
+    PendingEntry entry;
+    entry.uuid = resource.getUUID();
+    entry.stamp = stamp;
+    entry.hasStamp = true;
+
+    registerPending(filePath, entry);
+  }
+
+  void SaveResourceManifest()
+  {
+    ensureManifestLoaded();
+
+    ScopedImportTimer timer("Manifest", "Save", GOTHIC_CACHE_MANIFEST_NAME);
+
+    flushPendingAndSave();
+    clearJournal();
+  }
+
+  void FlushResourceManifestJournal()
+  {
+    for (ManifestShard& shard : s_Shards)
     {
-      s_GothicCache = bs::ResourceManifest::load(manifestPath, BsZenLib::GetCacheDirectory());
+      Lock lock(shard.mutex);
+
+      if (shard.journal.isEmpty()) continue;
+
+      writeToJournal(shard.journal);
+      shard.journal.clear();
+      shard.numJournalRecords = 0;
+    }
+  }
+
+  bool HasCachedResource(const bs::Path& filePath)
+  {
+    ensureManifestLoaded();
+
+    if (s_RegisteredPaths.contains(hashPath(filePath.toString()))) return true;
+
+    return s_GothicCache->filePathExists(filePath);
+  }
+
+  bool HasCachedResource(const bs::Path& filePath, const CacheSourceStamp& stamp)
+  {
+    ensureManifestLoaded();
+
+    String key = filePath.toString();
+    UINT64 hash = hashPath(key);
+
+    if (s_RegisteredPaths.contains(hash))
+    {
+      ManifestShard& shard = s_Shards[hash % NUM_MANIFEST_SHARDS];
+      Lock lock(shard.mutex);
+
+      auto it = shard.pending.find(key);
+
+      if (it != shard.pending.end())
+      {
+        return it->second.hasStamp && it->second.stamp == stamp;
+      }
+    }
+
+    auto it = s_Stamps.find(key);
+
+    if (it == s_Stamps.end()) return false;
+    if (it->second != stamp) return false;
+
+    return s_GothicCache->filePathExists(filePath);
+  }
+
+  bool FindCachedResourceUUID(const bs::Path& filePath, bs::UUID& outUUID)
+  {
+    ensureManifestLoaded();
+
+    String key = filePath.toString();
+    UINT64 hash = hashPath(key);
+
+    if (s_RegisteredPaths.contains(hash))
+    {
+      ManifestShard& shard = s_Shards[hash % NUM_MANIFEST_SHARDS];
+      Lock lock(shard.mutex);
+
+      auto it = shard.pending.find(key);
+
+      if (it != shard.pending.end())
+      {
+        outUUID = it->second.uuid;
+        return true;
+      }
+    }
+
+    return s_GothicCache->filePathToUUID(filePath, outUUID);
+  }
+
+  UINT64 HashSourceData(const UINT8* data, size_t size)
+  {
+    // XXH64, see https://github.com/Cyan4973/xxHash
+    constexpr UINT64 PRIME1 = 11400714785074694791ull;
+    constexpr UINT64 PRIME2 = 14029467366897019727ull;
+    constexpr UINT64 PRIME3 = 1609587929392839161ull;
+    constexpr UINT64 PRIME4 = 9650029242287828579ull;
+    constexpr UINT64 PRIME5 = 2870177450012600261ull;
+
+    auto rotl = [](UINT64 x, int r) { return (x << r) | (x >> (64 - r)); };
+
+    auto read64 = [](const UINT8* p) {
+      UINT64 v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    };
+
+    auto read32 = [](const UINT8* p) {
+      UINT32 v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    };
+
+    auto round = [&](UINT64 acc, UINT64 input) {
+      acc += input * PRIME2;
+      acc = rotl(acc, 31);
+      return acc * PRIME1;
+    };
+
+    auto mergeRound = [&](UINT64 acc, UINT64 val) {
+      acc ^= round(0, val);
+      return acc * PRIME1 + PRIME4;
+    };
+
+    const UINT8* p = data;
+    const UINT8* end = data + size;
+    UINT64 h;
+
+    if (size >= 32)
+    {
+      UINT64 v1 = PRIME1 + PRIME2;
+      UINT64 v2 = PRIME2;
+      UINT64 v3 = 0;
+      UINT64 v4 = 0 - PRIME1;
+
+      const UINT8* limit = end - 32;
+
+      do
+      {
+        v1 = round(v1, read64(p + 0));
+        v2 = round(v2, read64(p + 8));
+        v3 = round(v3, read64(p + 16));
+        v4 = round(v4, read64(p + 24));
+        p += 32;
+      } while (p <= limit);
 
-      bs::gResources().registerResourceManifest(s_GothicCache);
+      h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+      h = mergeRound(h, v1);
+      h = mergeRound(h, v2);
+      h = mergeRound(h, v3);
+      h = mergeRound(h, v4);
     }
     else
     {
-      s_GothicCache = bs::ResourceManifest::create(GOTHIC_CACHE_MANIFEST_NAME);
+      h = PRIME5;
     }
+
+    h += (UINT64)size;
+
+    for (; p + 8 <= end; p += 8)
+    {
+      h ^= round(0, read64(p));
+      h = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+
+    if (p + 4 <= end)
+    {
+      h ^= (UINT64)read32(p) * PRIME1;
+      h = rotl(h, 23) * PRIME2 + PRIME3;
+      p += 4;
+    }
+
+    for (; p < end; p++)
+    {
+      h ^= (*p) * PRIME5;
+      h = rotl(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+
+    return h;
   }
 
-  void AddToResourceManifest(bs::HResource resource, const bs::Path& filePath)
+  bool MakeCacheSourceStamp(const bs::String& originalFile, const VDFS::FileIndex& vdfs,
+                            bs::UINT32 importerVersion, CacheSourceStamp& outStamp)
+  {
+    if (!vdfs.hasFile(originalFile.c_str())) return false;
+
+    std::vector<uint8_t> data;
+    vdfs.getFileData(originalFile.c_str(), data);
+
+    outStamp.sourceHash = HashSourceData(data.data(), data.size());
+    outStamp.importerVersion = importerVersion;
+
+    return true;
+  }
+
+}  // namespace BsZenLib
+
+static void ensureManifestLoaded()
+{
+  if (s_IsGothicCacheLoaded.load(std::memory_order_acquire)) return;
+
+  Lock lock(s_LoadMutex);
+
+  // Someone else might have loaded it while we were waiting
+  if (s_IsGothicCacheLoaded.load(std::memory_order_relaxed)) return;
+
+  loadResourceManifestLocked();
+}
+
+static void registerPending(const Path& filePath, const PendingEntry& entry)
+{
+  ensureManifestLoaded();
+
+  String key = filePath.toString();
+  UINT64 hash = hashPath(key);
+
+  ManifestShard& shard = s_Shards[hash % NUM_MANIFEST_SHARDS];
+
   {
-    if (!s_GothicCache)
+    Lock lock(shard.mutex);
+    shard.pending[key] = entry;
+    writeJournalRecord(key, entry, shard.journal);
+
+    // Written while still holding the shard, so lines of the same path keep their order
+    if (++shard.numJournalRecords >= JOURNAL_BATCH_RECORDS)
     {
-      LoadResourceManifest();
+      writeToJournal(shard.journal);
+      shard.journal.clear();
+      shard.numJournalRecords = 0;
     }
+  }
+
+  s_RegisteredPaths.insert(hash);
+}
 
-    s_GothicCache->registerResource(resource.getUUID(), filePath);
+static void loadResourceManifestLocked()
+{
+  bs::Path manifestPath = BsZenLib::GothicPathToCachedManifest(GOTHIC_CACHE_MANIFEST_NAME);
+
+  if (bs::FileSystem::exists(manifestPath))
+  {
+    s_GothicCache = bs::ResourceManifest::load(manifestPath, BsZenLib::GetCacheDirectory());
+  }
+  else
+  {
+    s_GothicCache = bs::ResourceManifest::create(GOTHIC_CACHE_MANIFEST_NAME);
   }
 
-  void SaveResourceManifest()
+  // Also register a new one, so resources flushed into it can be looked up by UUID
+  bs::gResources().registerResourceManifest(s_GothicCache);
+
+  loadStamps();
+
+  // Registrations of a run which did not get to save the manifest
+  if (replayJournal() > 0)
   {
-    if (!s_GothicCache)
+    flushPendingAndSave();
+    clearJournal();
+  }
+
+  s_IsGothicCacheLoaded.store(true, std::memory_order_release);
+}
+
+/**
+ * FNV-1a. Paths are short, so there is no need for anything fancier.
+ */
+static UINT64 hashPath(const String& path)
+{
+  UINT64 hash = 0xcbf29ce484222325ull;
+
+  for (char c : path)
+  {
+    hash ^= (UINT8)c;
+    hash *= 0x100000001b3ull;
+  }
+
+  return hash;
+}
+
+static Path stampsFilePath()
+{
+  return BsZenLib::GetCacheDirectory() + Path(GOTHIC_CACHE_STAMPS_FILE);
+}
+
+static void loadStamps()
+{
+  s_Stamps.clear();
+
+  LineRecordReader records;
+
+  if (!records.open(stampsFilePath())) return;
+
+  while (records.nextRecord())
+  {
+    // Format: <hash> <version> <path relative to cache directory>
+    BsZenLib::CacheSourceStamp stamp;
+
+    if (!records.read(stamp.sourceHash) || !records.read(stamp.importerVersion)) continue;
+
+    String relative = records.readRest();
+
+    if (relative.empty()) continue;
+
+    s_Stamps[(BsZenLib::GetCacheDirectory() + Path(relative)).toString()] = stamp;
+  }
+}
+
+static void saveStamps()
+{
+  LineRecordWriter records;
+  Path cacheDirectory = BsZenLib::GetCacheDirectory();
+
+  for (const auto& entry : s_Stamps)
+  {
+    records.write(entry.second.sourceHash);
+    records.write(entry.second.importerVersion);
+    records.endRecord(Path(entry.first).getRelative(cacheDirectory).toString());
+  }
+
+  if (!records.save(stampsFilePath()))
+  {
+    BS_LOG(Error, Uncategorized, "Could not write cache stamps to {0}", stampsFilePath());
+  }
+}
+
+/**
+ * Moves all pending registrations into the manifest and writes manifest and stamps to disk.
+ */
+static void flushPendingAndSave()
+{
+  for (ManifestShard& shard : s_Shards)
+  {
+    Lock lock(shard.mutex);
+
+    for (const auto& entry : shard.pending)
     {
-      LoadResourceManifest();
+      s_GothicCache->registerResource(entry.second.uuid, Path(entry.first));
+
+      if (entry.second.hasStamp)
+      {
+        s_Stamps[entry.first] = entry.second.stamp;
+      }
+      else
+      {
+        // Re-registered without stamp, the old one does not describe it anymore
+        s_Stamps.erase(entry.first);
+      }
     }
 
-    bs::Path manifestPath = BsZenLib::GothicPathToCachedManifest(GOTHIC_CACHE_MANIFEST_NAME);
-    bs::ResourceManifest::save(s_GothicCache, manifestPath, BsZenLib::GetCacheDirectory());
+    // Part of the manifest now, no need to journal them anymore
+    shard.pending.clear();
+    shard.journal.clear();
+    shard.numJournalRecords = 0;
   }
 
-  bool HasCachedResource(const bs::Path& filePath)
+  bs::Path manifestPath = BsZenLib::GothicPathToCachedManifest(GOTHIC_CACHE_MANIFEST_NAME);
+  bs::ResourceManifest::save(s_GothicCache, manifestPath, BsZenLib::GetCacheDirectory());
+
+  saveStamps();
+}
+
+static Path journalFilePath()
+{
+  return BsZenLib::GetCacheDirectory() + Path(GOTHIC_CACHE_JOURNAL_FILE);
+}
+
+static void writeJournalRecord(const String& key, const PendingEntry& entry,
+                               LineRecordWriter& records)
+{
+  records.write(entry.uuid.toString());
+
+  if (entry.hasStamp)
+  {
+    records.write(entry.stamp.sourceHash);
+    records.write(entry.stamp.importerVersion);
+  }
+  else
   {
-    if (!s_GothicCache)
+    records.write(String("-"));
+    records.write(String("-"));
+  }
+
+  records.endRecord(Path(key).getRelative(BsZenLib::GetCacheDirectory()).toString());
+}
+
+static void writeToJournal(const LineRecordWriter& records)
+{
+  Lock lock(s_JournalMutex);
+
+  if (!s_Journal.append(journalFilePath(), records))
+  {
+    BS_LOG(Error, Uncategorized, "Could not open manifest journal {0}", journalFilePath());
+  }
+}
+
+
+/**
+ * Puts the registrations found in the journal into the pending shards, so they get into the
+ * manifest on the next flush. Must only be called while loading the manifest.
+ *
+ * @return Number of registrations replayed.
+ */
+static UINT32 replayJournal()
+{
+  LineRecordReader records;
+
+  if (!records.open(journalFilePath())) return 0;
+
+  UINT32 numReplayed = 0;
+
+  while (records.nextRecord())
+  {
+    // Format: <uuid> <hash|-> <version|-> <path relative to cache directory>
+    String uuid;
+    String hash;
+    String version;
+
+    if (!records.read(uuid) || !records.read(hash) || !records.read(version)) continue;
+
+    PendingEntry entry;
+    entry.uuid = UUID(uuid);
+    entry.hasStamp = hash != "-";
+
+    if (entry.hasStamp)
     {
-      LoadResourceManifest();
+      entry.stamp.sourceHash = parseUINT64(hash);
+      entry.stamp.importerVersion = parseUINT32(version);
     }
 
-    return s_GothicCache->filePathExists(filePath);
+    String relative = records.readRest();
+
+    if (relative.empty()) continue;
+
+    String key = (BsZenLib::GetCacheDirectory() + Path(relative)).toString();
+    UINT64 keyHash = hashPath(key);
+
+    // Later lines win, same as registering the same path twice
+    s_Shards[keyHash % NUM_MANIFEST_SHARDS].pending[key] = entry;
+    s_RegisteredPaths.insert(keyHash);
+
+    numReplayed++;
+  }
+
+  if (numReplayed > 0)
+  {
+    BS_LOG(Info, Uncategorized, "Replayed {0} registration(s) from the manifest journal",
+           numReplayed);
   }
 
+  return numReplayed;
+}
 
-}  // namespace BsZenLib
+/**
+ * Empties the journal, once everything in it has been saved into the manifest.
+ */
+static void clearJournal()
+{
+  Lock lock(s_JournalMutex);
+
+  s_Journal.close();
+
+  if (FileSystem::isFile(journalFilePath()))
+  {
+    FileSystem::remove(journalFilePath());
+  }
+}
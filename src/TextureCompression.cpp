@@ -0,0 +1,136 @@
+/**
+ * Texture Compression
+ * ===================
+ *
+ * Encoding itself is left to bs::PixelUtil::compress(), which is single threaded. Block
+ * compressed formats store blocks of 4x4 pixels row by row, so a band of whole block rows
+ * encodes into a contiguous slice of the output. Each band is encoded on its own, straight
+ * into its slice.
+ *
+ * Depending on how bs::f was built, its encoder might not support BC7 and return without writing
+ * anything, leaving blocks of zeros behind. That is checked once by encoding a single block,
+ * and BC1/BC3 is used instead if it fails.
+ */
+
+#include "TextureCompression.hpp"
+#include "ParallelFor.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace bs;
+using namespace BsZenLib;
+
+/**
+ * Bands smaller than this are not worth the overhead of a task. Encoding is slow, especially
+ * BC7, so these are kept rather small.
+ */
+static constexpr UINT32 MIN_PIXELS_PER_BAND = 16 * 1024;
+
+static constexpr UINT32 BLOCK_SIZE = 4;
+
+static bool isBC7Supported();
+
+// - Implementation --------------------------------------------------------------------------------
+
+bool BsZenLib::HasTransparentPixelsRGBA8(const bs::PixelData& image)
+{
+  const UINT8* data = image.getData();
+  size_t numPixels = (size_t)image.getWidth() * image.getHeight();
+
+  for (size_t i = 0; i < numPixels; i++)
+  {
+    if (data[4 * i + 3] != 255) return true;
+  }
+
+  return false;
+}
+
+bs::PixelFormat BsZenLib::ChooseCompressedFormat(const bs::PixelData& image,
+                                                 TextureCompression compression)
+{
+  switch (compression)
+  {
+    case TextureCompression::BC1OrBC3:
+      return HasTransparentPixelsRGBA8(image) ? PF_BC3 : PF_BC1;
+
+    case TextureCompression::BC7:
+      if (isBC7Supported()) return PF_BC7;
+
+      return ChooseCompressedFormat(image, TextureCompression::BC1OrBC3);
+
+    case TextureCompression::None:
+    default:
+      return PF_UNKNOWN;
+  }
+}
+
+bs::SPtr<bs::PixelData> BsZenLib::CompressRGBA8(const bs::PixelData& image,
+                                                bs::PixelFormat format,
+                                                bs::CompressionQuality quality, bool isSRGB)
+{
+  const UINT32 width = image.getWidth();
+  const UINT32 height = image.getHeight();
+
+  SPtr<PixelData> compressed = PixelData::create(width, height, 1, format);
+
+  CompressionOptions options;
+  options.format = format;
+  options.alphaMode = (format == PF_BC1) ? AlphaMode::None : AlphaMode::Transparency;
+  options.isSRGB = isSRGB;
+  options.quality = quality;
+
+  const UINT32 numBlockRows = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  const UINT32 blockRowPixels = width * BLOCK_SIZE;
+  const UINT32 blockRowsPerBand = std::max(1u, MIN_PIXELS_PER_BAND / blockRowPixels);
+
+  // Size of a block row in the compressed image
+  const UINT32 blockRowBytes = PixelUtil::getMemorySize(width, BLOCK_SIZE, 1, format);
+
+  ParallelFor(numBlockRows, blockRowsPerBand, [&](UINT32 firstBlockRow, UINT32 lastBlockRow) {
+    UINT32 firstRow = firstBlockRow * BLOCK_SIZE;
+    UINT32 numRows = std::min(height, lastBlockRow * BLOCK_SIZE) - firstRow;
+
+    // Views into the source and target, neither of them own their data
+    PixelData source(width, numRows, 1, PF_RGBA8);
+    source.setExternalBuffer(image.getData() + (size_t)firstRow * width * 4);
+
+    PixelData target(width, numRows, 1, format);
+    target.setExternalBuffer(compressed->getData() + (size_t)firstBlockRow * blockRowBytes);
+
+    PixelUtil::compress(source, target, options);
+  });
+
+  return compressed;
+}
+
+/**
+ * Encodes a single block to find out whether the encoder of bs::f supports BC7. Only done once.
+ */
+static bool isBC7Supported()
+{
+  static const bool isSupported = []() {
+    PixelData source(BLOCK_SIZE, BLOCK_SIZE, 1, PF_RGBA8);
+    source.allocateInternalBuffer();
+    memset(source.getData(), 0x80, source.getSize());
+
+    PixelData target(BLOCK_SIZE, BLOCK_SIZE, 1, PF_BC7);
+    target.allocateInternalBuffer();
+    memset(target.getData(), 0, target.getSize());
+
+    CompressionOptions options;
+    options.format = PF_BC7;
+    options.quality = CompressionQuality::Fastest;
+
+    PixelUtil::compress(source, target, options);
+
+    // The lowest bits of a BC7 block select its mode, all of them being zero is not valid
+    if (target.getData()[0] != 0) return true;
+
+    BS_LOG(Warning, Uncategorized,
+           "The texture encoder of bs::f does not support BC7, using BC1/BC3 instead");
+
+    return false;
+  }();
+
+  return isSupported;
+}
@@ -0,0 +1,206 @@
+/**
+ * Texture Index
+ * =============
+ *
+ * The index lives in memory as a map by texture name, guarded by a single mutex. Lookups only
+ * hold it for a single map access, so there is no need for anything finer grained.
+ *
+ * On disk, it is an append-only text file `gothic-cache.textures` inside the cache directory,
+ * one entry per line:
+ *
+ *     <hash> <importer version> <width> <height> <format> <mips> <memory size> <name>
+ *
+ * Like the manifest journal, entries are appended and flushed as soon as a texture is cached,
+ * so they survive a crash. Caching a texture again appends a new line, later lines win. When
+ * loading finds more lines than textures, the file is rewritten with only the latest ones, as
+ * it is when a texture is removed.
+ *
+ * Textures whose cached file is not registered inside the resource manifest anymore, ie. because
+ * the cache directory has been cleaned, are dropped while loading, so they cost a single rewrite
+ * instead of one per texture found missing later on.
+ */
+
+#include "TextureIndex.hpp"
+#include "ImportPath.hpp"
+#include "LineRecords.hpp"
+#include "ResourceManifest.hpp"
+#include <Threading/BsThreading.h>
+
+using namespace bs;
+using namespace BsZenLib;
+
+constexpr auto TEXTURE_INDEX_FILE = "gothic-cache.textures";
+
+static Mutex s_IndexMutex;
+static bool s_IsIndexLoaded = false;
+static UnorderedMap<String, CachedTextureInfo> s_Index;
+static LineRecordAppender s_IndexFile;
+
+static void ensureIndexLoaded();
+static Path indexFilePath();
+static void writeEntry(const CachedTextureInfo& info, LineRecordWriter& records);
+static bool readEntry(LineRecordReader& records, CachedTextureInfo& outInfo);
+static void rewriteIndexFile();
+
+// - Implementation --------------------------------------------------------------------------------
+
+bool BsZenLib::FindCachedTextureInfo(const String& originalFileName, CachedTextureInfo& outInfo)
+{
+  Lock lock(s_IndexMutex);
+
+  ensureIndexLoaded();
+
+  auto it = s_Index.find(originalFileName);
+
+  if (it == s_Index.end()) return false;
+
+  outInfo = it->second;
+
+  return true;
+}
+
+Vector<CachedTextureInfo> BsZenLib::GetCachedTextureInfos()
+{
+  Lock lock(s_IndexMutex);
+
+  ensureIndexLoaded();
+
+  Vector<CachedTextureInfo> infos;
+  infos.reserve(s_Index.size());
+
+  for (const auto& entry : s_Index)
+  {
+    infos.push_back(entry.second);
+  }
+
+  return infos;
+}
+
+void BsZenLib::AddToTextureIndex(const CachedTextureInfo& info)
+{
+  Lock lock(s_IndexMutex);
+
+  ensureIndexLoaded();
+
+  s_Index[info.name] = info;
+
+  LineRecordWriter records;
+  writeEntry(info, records);
+
+  if (!s_IndexFile.append(indexFilePath(), records))
+  {
+    BS_LOG(Error, Uncategorized, "Could not open texture index {0}", indexFilePath());
+  }
+}
+
+void BsZenLib::RemoveFromTextureIndex(const String& originalFileName)
+{
+  Lock lock(s_IndexMutex);
+
+  ensureIndexLoaded();
+
+  if (s_Index.erase(originalFileName) == 0) return;
+
+  // Reopened on the next append, after the file has been replaced
+  s_IndexFile.close();
+
+  rewriteIndexFile();
+}
+
+/**
+ * Reads the index from disk, unless that happened already. Must be called with the index
+ * mutex held.
+ */
+static void ensureIndexLoaded()
+{
+  if (s_IsIndexLoaded) return;
+
+  s_IsIndexLoaded = true;
+
+  LineRecordReader records;
+
+  if (!records.open(indexFilePath())) return;
+
+  UINT32 numLines = 0;
+
+  while (records.nextRecord())
+  {
+    CachedTextureInfo info;
+
+    if (readEntry(records, info))
+    {
+      s_Index[info.name] = info;
+      numLines++;
+    }
+  }
+
+  for (auto it = s_Index.begin(); it != s_Index.end();)
+  {
+    if (HasCachedResource(GothicPathToCachedTexture(it->first.c_str())))
+    {
+      it++;
+    }
+    else
+    {
+      it = s_Index.erase(it);
+    }
+  }
+
+  if (numLines > s_Index.size() || records.hasCutOffRecord())
+  {
+    rewriteIndexFile();
+  }
+}
+
+static Path indexFilePath()
+{
+  return GetCacheDirectory() + Path(TEXTURE_INDEX_FILE);
+}
+
+static void writeEntry(const CachedTextureInfo& info, LineRecordWriter& records)
+{
+  records.write(info.sourceHash);
+  records.write(info.importerVersion);
+  records.write(info.width);
+  records.write(info.height);
+  records.write((UINT32)info.format);
+  records.write(info.numMips);
+  records.write(info.memorySize);
+  records.endRecord(info.name);
+}
+
+static bool readEntry(LineRecordReader& records, CachedTextureInfo& outInfo)
+{
+  UINT32 format;
+
+  if (!records.read(outInfo.sourceHash) || !records.read(outInfo.importerVersion) ||
+      !records.read(outInfo.width) || !records.read(outInfo.height) || !records.read(format) ||
+      !records.read(outInfo.numMips) || !records.read(outInfo.memorySize))
+  {
+    return false;
+  }
+
+  outInfo.format = (PixelFormat)format;
+  outInfo.name = records.readRest();
+
+  return !outInfo.name.empty();
+}
+
+/**
+ * Writes the index file anew, with only the latest entry of every texture. Must be called with
+ * the index mutex held and the append stream closed.
+ */
+static void rewriteIndexFile()
+{
+  LineRecordWriter records;
+
+  for (const auto& entry : s_Index)
+  {
+    writeEntry(entry.second, records);
+  }
+
+  if (!records.save(indexFilePath()))
+  {
+    BS_LOG(Error, Uncategorized, "Could not write texture index to {0}", indexFilePath());
+  }
+}
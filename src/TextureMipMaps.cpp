@@ -0,0 +1,272 @@
+/**
+ * Texture Mip-Maps
+ * ================
+ *
+ * Every level is downsampled from the one before it: First horizontally into a float buffer,
+ * then vertically into the level itself. The weights of both passes only depend on the sizes
+ * of the levels, so they are computed once per level and pass.
+ *
+ * Both passes work on rows independent of each other. Levels with enough pixels are therefore
+ * split into tiles of rows, which run on the task scheduler.
+ *
+ * Like bs::PixelUtil::genMipmaps(), this filters the stored values as they are, without
+ * converting from sRGB first.
+ */
+
+#include "TextureMipMaps.hpp"
+#include "ParallelFor.hpp"
+#include "ScratchBuffer.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace bs;
+using namespace BsZenLib;
+
+/**
+ * Tiles smaller than this are not worth the overhead of a task.
+ */
+static constexpr UINT32 MIN_PIXELS_PER_TILE = 64 * 1024;
+
+/**
+ * Half-width and shape of the Kaiser filter in pixels of the smaller level, same as used by
+ * bs::f (and originally NVTT).
+ */
+static constexpr float KAISER_RADIUS = 3.0f;
+static constexpr float KAISER_ALPHA = 4.0f;
+
+static constexpr float BOX_RADIUS = 0.5f;
+
+/**
+ * Which pixels of the larger level contribute to each pixel of the smaller one, and how much.
+ * Every pixel has the same number of taps, unused ones have a weight of 0.
+ */
+struct ResampleWeights
+{
+  UINT32 numTaps = 0;
+  Vector<UINT32> indices;
+  Vector<float> weights;
+};
+
+static ResampleWeights computeWeights(UINT32 srcSize, UINT32 dstSize, TextureMipFilter filter);
+static float evaluateFilter(float x, TextureMipFilter filter);
+static float besselI0(float x);
+static void downsampleRows(const UINT8* src, UINT32 srcWidth, float* dst, UINT32 dstWidth,
+                           const ResampleWeights& weights, UINT32 firstRow, UINT32 lastRow);
+static void downsampleColumns(const float* src, UINT8* dst, UINT32 width,
+                              const ResampleWeights& weights, UINT32 firstRow, UINT32 lastRow);
+static void forEachRowTile(UINT32 numRows, UINT32 rowWidth,
+                           const std::function<void(UINT32, UINT32)>& work);
+
+// - Implementation --------------------------------------------------------------------------------
+
+bs::Vector<bs::SPtr<bs::PixelData>> BsZenLib::GenerateMipMapsRGBA8(const bs::PixelData& base,
+                                                                   TextureMipFilter filter)
+{
+  Vector<SPtr<PixelData>> levels;
+
+  const UINT8* src = base.getData();
+  UINT32 srcWidth = base.getWidth();
+  UINT32 srcHeight = base.getHeight();
+
+  ScratchBuffer<Vector<float>> horizontalScratch;
+  Vector<float>& horizontal = *horizontalScratch;
+
+  while (srcWidth > 1 || srcHeight > 1)
+  {
+    UINT32 dstWidth = std::max(1u, srcWidth / 2);
+    UINT32 dstHeight = std::max(1u, srcHeight / 2);
+
+    SPtr<PixelData> level = PixelData::create(dstWidth, dstHeight, 1, PF_RGBA8);
+    UINT8* dst = level->getData();
+
+    ResampleWeights rowWeights = computeWeights(srcWidth, dstWidth, filter);
+    ResampleWeights columnWeights = computeWeights(srcHeight, dstHeight, filter);
+
+    // Narrowed rows of the larger level, 4 floats per pixel
+    horizontal.resize((size_t)dstWidth * srcHeight * 4);
+
+    forEachRowTile(srcHeight, srcWidth, [&](UINT32 firstRow, UINT32 lastRow) {
+      downsampleRows(src, srcWidth, horizontal.data(), dstWidth, rowWeights, firstRow, lastRow);
+    });
+
+    forEachRowTile(dstHeight, dstWidth * columnWeights.numTaps, [&](UINT32 firstRow,
+                                                                     UINT32 lastRow) {
+      downsampleColumns(horizontal.data(), dst, dstWidth, columnWeights, firstRow, lastRow);
+    });
+
+    levels.push_back(level);
+
+    src = dst;
+    srcWidth = dstWidth;
+    srcHeight = dstHeight;
+  }
+
+  return levels;
+}
+
+static ResampleWeights computeWeights(UINT32 srcSize, UINT32 dstSize, TextureMipFilter filter)
+{
+  float scale = (float)srcSize / dstSize;
+  float radius = (filter == TextureMipFilter::Kaiser ? KAISER_RADIUS : BOX_RADIUS) * scale;
+
+  ResampleWeights result;
+  result.numTaps = (UINT32)std::ceil(2.0f * radius) + 1;
+  result.indices.resize((size_t)dstSize * result.numTaps, 0);
+  result.weights.resize((size_t)dstSize * result.numTaps, 0.0f);
+
+  for (UINT32 i = 0; i < dstSize; i++)
+  {
+    // Center of the smaller pixel in pixels of the larger level
+    float center = (i + 0.5f) * scale - 0.5f;
+    INT32 first = (INT32)std::ceil(center - radius);
+
+    UINT32* indices = &result.indices[(size_t)i * result.numTaps];
+    float* weights = &result.weights[(size_t)i * result.numTaps];
+    float sum = 0.0f;
+
+    for (UINT32 tap = 0; tap < result.numTaps; tap++)
+    {
+      INT32 position = first + (INT32)tap;
+      float weight = evaluateFilter((position - center) / scale, filter);
+
+      // Pixels outside the image are clamped to the edge
+      indices[tap] = (UINT32)std::min(std::max(position, 0), (INT32)srcSize - 1);
+      weights[tap] = weight;
+      sum += weight;
+    }
+
+    if (sum != 0.0f)
+    {
+      for (UINT32 tap = 0; tap < result.numTaps; tap++)
+      {
+        weights[tap] /= sum;
+      }
+    }
+  }
+
+  return result;
+}
+
+/**
+ * @param x  Distance to the center in pixels of the smaller level.
+ */
+static float evaluateFilter(float x, TextureMipFilter filter)
+{
+  x = std::abs(x);
+
+  if (filter == TextureMipFilter::Box)
+  {
+    return x <= BOX_RADIUS ? 1.0f : 0.0f;
+  }
+
+  if (x >= KAISER_RADIUS) return 0.0f;
+
+  float sinc = (x < 1e-6f) ? 1.0f : std::sin(Math::PI * x) / (Math::PI * x);
+  float t = x / KAISER_RADIUS;
+
+  return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / besselI0(KAISER_ALPHA);
+}
+
+/**
+ * Modified bessel function of the first kind, order 0. Only used to compute the weights.
+ */
+static float besselI0(float x)
+{
+  float sum = 1.0f;
+  float term = 1.0f;
+  float halfX = x * 0.5f;
+
+  for (UINT32 k = 1; k < 32 && term > sum * 1e-8f; k++)
+  {
+    float factor = halfX / k;
+    term *= factor * factor;
+    sum += term;
+  }
+
+  return sum;
+}
+
+static void downsampleRows(const UINT8* src, UINT32 srcWidth, float* dst, UINT32 dstWidth,
+                           const ResampleWeights& weights, UINT32 firstRow, UINT32 lastRow)
+{
+  for (UINT32 y = firstRow; y < lastRow; y++)
+  {
+    const UINT8* srcRow = src + (size_t)y * srcWidth * 4;
+    float* dstRow = dst + (size_t)y * dstWidth * 4;
+
+    for (UINT32 x = 0; x < dstWidth; x++)
+    {
+      const UINT32* indices = &weights.indices[(size_t)x * weights.numTaps];
+      const float* tapWeights = &weights.weights[(size_t)x * weights.numTaps];
+
+      float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+
+      for (UINT32 tap = 0; tap < weights.numTaps; tap++)
+      {
+        const UINT8* pixel = srcRow + indices[tap] * 4;
+        float weight = tapWeights[tap];
+
+        r += pixel[0] * weight;
+        g += pixel[1] * weight;
+        b += pixel[2] * weight;
+        a += pixel[3] * weight;
+      }
+
+      dstRow[x * 4 + 0] = r;
+      dstRow[x * 4 + 1] = g;
+      dstRow[x * 4 + 2] = b;
+      dstRow[x * 4 + 3] = a;
+    }
+  }
+}
+
+static void downsampleColumns(const float* src, UINT8* dst, UINT32 width,
+                              const ResampleWeights& weights, UINT32 firstRow, UINT32 lastRow)
+{
+  const UINT32 rowSize = width * 4;
+
+  Vector<float> accumulated(rowSize);
+
+  for (UINT32 y = firstRow; y < lastRow; y++)
+  {
+    std::fill(accumulated.begin(), accumulated.end(), 0.0f);
+
+    const UINT32* indices = &weights.indices[(size_t)y * weights.numTaps];
+    const float* tapWeights = &weights.weights[(size_t)y * weights.numTaps];
+
+    for (UINT32 tap = 0; tap < weights.numTaps; tap++)
+    {
+      const float* srcRow = src + (size_t)indices[tap] * rowSize;
+      float weight = tapWeights[tap];
+
+      if (weight == 0.0f) continue;
+
+      for (UINT32 i = 0; i < rowSize; i++)
+      {
+        accumulated[i] += srcRow[i] * weight;
+      }
+    }
+
+    UINT8* dstRow = dst + (size_t)y * rowSize;
+
+    for (UINT32 i = 0; i < rowSize; i++)
+    {
+      // Negative lobes of the Kaiser filter can overshoot
+      float value = std::min(std::max(accumulated[i] + 0.5f, 0.0f), 255.0f);
+      dstRow[i] = (UINT8)value;
+    }
+  }
+}
+
+/**
+ * Splits the rows into tiles and runs the given function on all of them in parallel.
+ *
+ * @param rowWidth  Roughly how much work a single row is, to decide how many rows go into a tile.
+ */
+static void forEachRowTile(UINT32 numRows, UINT32 rowWidth,
+                           const std::function<void(UINT32, UINT32)>& work)
+{
+  UINT32 rowsPerTile = std::max(1u, MIN_PIXELS_PER_TILE / std::max(1u, rowWidth));
+
+  ParallelFor(numRows, rowsPerTile, work);
+}
@@ -0,0 +1,235 @@
+/**
+ * Texture Streaming
+ * =================
+ *
+ * Requests are kept in a map by texture name, so requesting the same texture twice only
+ * raises its priority. UpdateTextureStreaming() picks the requests to start by scanning all of
+ * them. There are rarely more than a few thousand textures, and only a few loads are started
+ * per frame, so nothing more clever is needed.
+ *
+ * Loading goes through gResources().loadAsync(), unless the texture is inside the mounted cache
+ * pack. Reading from the mapped pack is fast enough to just do it right away.
+ *
+ * A load which failed counts as finished, so it does not keep its slot. Its callbacks are not
+ * called, the material keeps the tail.
+ */
+
+#include "TextureStreaming.hpp"
+#include "CachePack.hpp"
+#include "ImportPath.hpp"
+#include "ImportTexture.hpp"
+#include "ResourceManifest.hpp"
+#include "TextureIndex.hpp"
+#include <atomic>
+#include <Resources/BsResources.h>
+#include <Threading/BsThreading.h>
+
+using namespace bs;
+using namespace BsZenLib;
+
+/**
+ * Name of the material parameter the importer puts the texture into.
+ */
+static const char* ALBEDO_PARAMETER = "gAlbedoTex";
+
+struct DetailRequest
+{
+  float priority = 0.0f;
+  Vector<std::function<void(const HTexture&)>> callbacks;
+
+  /** Set once loading has started */
+  HTexture texture;
+  bool isLoading = false;
+};
+
+static std::atomic<bool> s_IsStreamingEnabled{false};
+static Mutex s_RequestsMutex;
+static UnorderedMap<String, DetailRequest> s_Requests;
+
+static HTexture startLoading(const String& originalFileName);
+static bool hasFinishedLoading(const String& originalFileName, const DetailRequest& request);
+static bool isFullTexture(const HTexture& texture);
+
+// - Implementation --------------------------------------------------------------------------------
+
+void BsZenLib::SetTextureStreamingEnabled(bool enabled)
+{
+  s_IsStreamingEnabled.store(enabled);
+}
+
+bool BsZenLib::IsTextureStreamingEnabled()
+{
+  return s_IsStreamingEnabled.load();
+}
+
+bool BsZenLib::HasCachedTextureTail(const bs::String& originalFileName)
+{
+  return HasCachedResource(GothicPathToCachedTextureTail(originalFileName));
+}
+
+bs::HTexture BsZenLib::LoadCachedTextureTail(const bs::String& originalFileName)
+{
+  if (!HasCachedTextureTail(originalFileName)) return LoadCachedTexture(originalFileName);
+
+  return LoadCachedResource<Texture>(GothicPathToCachedTextureTail(originalFileName));
+}
+
+void BsZenLib::RequestTextureDetail(const bs::String& originalFileName, float priority,
+                                    std::function<void(const bs::HTexture&)> onLoaded)
+{
+  Lock lock(s_RequestsMutex);
+
+  auto it = s_Requests.find(originalFileName);
+
+  if (it == s_Requests.end())
+  {
+    DetailRequest& request = s_Requests[originalFileName];
+    request.priority = priority;
+    request.callbacks.push_back(std::move(onLoaded));
+  }
+  else
+  {
+    it->second.priority = std::max(it->second.priority, priority);
+    it->second.callbacks.push_back(std::move(onLoaded));
+  }
+}
+
+void BsZenLib::RequestMaterialDetail(const bs::HMaterial& material, float priority)
+{
+  if (!material.isLoaded(false)) return;
+
+  HTexture current = material->getTexture(ALBEDO_PARAMETER);
+
+  // Textures are named after their original file, tails included
+  if (!current.isLoaded(false) || current->getName().empty()) return;
+
+  if (isFullTexture(current)) return;
+
+  HMaterial target = material;
+
+  RequestTextureDetail(current->getName(), priority, [target](const HTexture& texture) {
+    if (target.isLoaded(false)) target->setTexture(ALBEDO_PARAMETER, texture);
+  });
+}
+
+void BsZenLib::UpdateTextureStreaming(bs::UINT32 maxLoadsInFlight)
+{
+  Vector<DetailRequest> finished;
+
+  {
+    Lock lock(s_RequestsMutex);
+
+    UINT32 numLoading = 0;
+
+    for (auto it = s_Requests.begin(); it != s_Requests.end();)
+    {
+      DetailRequest& request = it->second;
+
+      if (hasFinishedLoading(it->first, request))
+      {
+        finished.push_back(std::move(request));
+        it = s_Requests.erase(it);
+        continue;
+      }
+
+      if (request.isLoading) numLoading++;
+
+      ++it;
+    }
+
+    while (numLoading < maxLoadsInFlight)
+    {
+      auto best = s_Requests.end();
+
+      for (auto it = s_Requests.begin(); it != s_Requests.end(); ++it)
+      {
+        if (it->second.isLoading) continue;
+
+        if (best == s_Requests.end() || it->second.priority > best->second.priority) best = it;
+      }
+
+      if (best == s_Requests.end()) break;
+
+      best->second.texture = startLoading(best->first);
+      best->second.isLoading = true;
+      numLoading++;
+    }
+  }
+
+  // Outside the lock, so callbacks may request more textures
+  for (const DetailRequest& request : finished)
+  {
+    if (!request.texture.isLoaded(false)) continue;
+
+    for (const auto& callback : request.callbacks)
+    {
+      callback(request.texture);
+    }
+  }
+}
+
+bs::UINT32 BsZenLib::GetNumPendingTextureDetailRequests()
+{
+  Lock lock(s_RequestsMutex);
+
+  return (UINT32)s_Requests.size();
+}
+
+void BsZenLib::CancelTextureDetailRequests()
+{
+  Lock lock(s_RequestsMutex);
+
+  s_Requests.clear();
+}
+
+/**
+ * @return Handle of the texture being loaded. Empty if it has not been cached.
+ */
+static HTexture startLoading(const String& originalFileName)
+{
+  Path path = GothicPathToCachedTexture(originalFileName);
+
+  HResource packed = LoadPackedResource(path);
+
+  if (packed) return static_resource_cast<Texture>(packed);
+
+  if (!HasCachedResource(path))
+  {
+    BS_LOG(Warning, Uncategorized, "Requested detail of texture {0}, which is not cached",
+           originalFileName);
+
+    return {};
+  }
+
+  return gResources().loadAsync<Texture>(path);
+}
+
+/**
+ * Also true if loading failed, which bs::f only tells by not loading the texture anymore.
+ */
+static bool hasFinishedLoading(const String& originalFileName, const DetailRequest& request)
+{
+  if (!request.isLoading) return false;
+  if (!request.texture || request.texture.isLoaded(false)) return true;
+
+  const bool checkInProgress = true;
+  if (gResources().isLoaded(request.texture.getUUID(), checkInProgress)) return false;
+
+  BS_LOG(Warning, Uncategorized, "Could not load detail of texture {0}", originalFileName);
+
+  return true;
+}
+
+/**
+ * @return Whether the texture has all mip-map levels of the cached texture it is named after,
+ *         so it is no tail and there is no detail left to load.
+ */
+static bool isFullTexture(const HTexture& texture)
+{
+  CachedTextureInfo info;
+
+  if (!FindCachedTextureInfo(texture->getName(), info)) return false;
+
+  // bs::f does not count the base level as mip-map
+  return texture->getProperties().getNumMipmaps() + 1 >= info.numMips;
+}
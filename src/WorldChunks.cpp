@@ -0,0 +1,511 @@
+/**
+ * World Chunks
+ * ============
+ *
+ * Triangles are put into the grid cell holding their center, looking down onto the world from
+ * above. Gothic worlds are mostly flat, so splitting the height as well would only produce more
+ * and smaller chunks.
+ *
+ * Every chunk gets a copy of the vertices it uses and keeps the submeshes of the world mesh it
+ * has triangles of, in their original order. Chunks are cached like any other static mesh, but
+ * reference the materials of the whole world mesh instead of importing their own.
+ *
+ *
+ * Chunk index
+ * -----------
+ *
+ * The chunk index is a text file next to the cached world. The first line holds the chunk size
+ * and the source stamp of the world it was built with, then there is one line per chunk:
+ *
+ *     <chunk size> <source hash> <importer version>
+ *     <min x> <min y> <min z> <max x> <max y> <max z> <mesh name>
+ */
+
+#include "WorldChunks.hpp"
+#include "ImportMetrics.hpp"
+#include "ImportPath.hpp"
+#include "ImportStaticMesh.hpp"
+#include "LineRecords.hpp"
+#include "ParallelFor.hpp"
+#include "TextureStreaming.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <Components/BsCMeshCollider.h>
+#include <Components/BsCRenderable.h>
+#include <Physics/BsPhysicsMesh.h>
+#include <Resources/BsResources.h>
+#include <zenload/zTypes.h>
+
+using namespace bs;
+using namespace BsZenLib;
+
+/**
+ * Cell of the chunk grid, counted in chunks from the origin.
+ */
+struct ChunkCoord
+{
+  INT32 x;
+  INT32 z;
+
+  bool operator<(const ChunkCoord& other) const
+  {
+    return std::tie(x, z) < std::tie(other.x, other.z);
+  }
+};
+
+/**
+ * A triangle of the world mesh, by the submesh it is part of and its first index in there.
+ */
+struct ChunkTriangle
+{
+  UINT32 submesh;
+  UINT32 firstIndex;
+};
+
+static std::atomic<float> s_ChunkSize{0.0f};
+
+static Map<ChunkCoord, Vector<ChunkTriangle>> assignTrianglesToChunks(
+    const ZenLoad::PackedMesh& worldMesh, float chunkSize);
+static void buildChunk(const ZenLoad::PackedMesh& worldMesh, const Vector<HMaterial>& materials,
+                       const Vector<ChunkTriangle>& triangles, ZenLoad::PackedMesh& outMesh,
+                       Vector<HMaterial>& outMaterials, AABox& outBounds);
+static String chunkMeshName(const String& worldName, const ChunkCoord& coord);
+static bool saveChunkIndex(const String& worldName, float chunkSize,
+                           const CacheSourceStamp& stamp, const Vector<WorldChunk>& chunks);
+static bool readChunkIndex(const String& worldName, float& outChunkSize,
+                           CacheSourceStamp& outStamp, Vector<WorldChunk>& outChunks);
+static bool loadChunk(const HSceneObject& chunkSO, const WorldChunk& chunk, float distance);
+static void unloadChunk(const HSceneObject& chunkSO);
+static bool isChunkLoaded(const HSceneObject& chunkSO);
+static float distanceToBounds(const AABox& bounds, const Vector3& position);
+
+// - Implementation --------------------------------------------------------------------------------
+
+void BsZenLib::SetWorldChunkSize(float meters)
+{
+  s_ChunkSize = std::max(meters, 0.0f);
+}
+
+float BsZenLib::GetWorldChunkSize()
+{
+  return s_ChunkSize.load();
+}
+
+bool BsZenLib::ImportAndCacheWorldChunks(const String& worldName,
+                                         const ZenLoad::PackedMesh& worldMesh,
+                                         const Vector<HMaterial>& materials,
+                                         const CacheSourceStamp& stamp)
+{
+  const float chunkSize = s_ChunkSize.load();
+
+  if (chunkSize <= 0.0f) return false;
+
+  BS_LOG(Info, Uncategorized, "Caching World Chunks: " + worldName);
+
+  Vector<std::pair<ChunkCoord, Vector<ChunkTriangle>>> cells;
+  {
+    ScopedImportTimer timer("StaticMesh", "SplitChunks", worldName);
+
+    for (auto& cell : assignTrianglesToChunks(worldMesh, chunkSize))
+    {
+      cells.emplace_back(cell.first, std::move(cell.second));
+    }
+  }
+
+  Vector<WorldChunk> chunks(cells.size());
+  std::atomic<bool> hasFailed{false};
+
+  ParallelFor((UINT32)cells.size(), 1, [&](UINT32 first, UINT32 last) {
+    for (UINT32 i = first; i < last; i++)
+    {
+      ZenLoad::PackedMesh chunkMesh;
+      Vector<HMaterial> chunkMaterials;
+
+      chunks[i].meshName = chunkMeshName(worldName, cells[i].first);
+
+      buildChunk(worldMesh, materials, cells[i].second, chunkMesh, chunkMaterials,
+                 chunks[i].bounds);
+
+      if (!ImportAndCacheStaticMesh(chunks[i].meshName, chunkMesh, chunkMaterials, stamp))
+      {
+        hasFailed = true;
+      }
+    }
+  });
+
+  if (hasFailed)
+  {
+    BS_LOG(Warning, Uncategorized, "Load Failed (World Chunks): " + worldName);
+    return false;
+  }
+
+  return saveChunkIndex(worldName, chunkSize, stamp, chunks);
+}
+
+bool BsZenLib::HasCachedWorldChunks(const String& worldName, const CacheSourceStamp& stamp)
+{
+  float chunkSize;
+  CacheSourceStamp cachedStamp;
+  Vector<WorldChunk> chunks;
+
+  if (!readChunkIndex(worldName, chunkSize, cachedStamp, chunks)) return false;
+
+  return chunkSize == s_ChunkSize.load() && cachedStamp == stamp;
+}
+
+Vector<WorldChunk> BsZenLib::LoadWorldChunkIndex(const String& worldName)
+{
+  float chunkSize;
+  CacheSourceStamp stamp;
+  Vector<WorldChunk> chunks;
+
+  if (!readChunkIndex(worldName, chunkSize, stamp, chunks)) return {};
+
+  return chunks;
+}
+
+HSceneObject BsZenLib::CreateWorldChunkObjects(const String& worldName,
+                                               const Vector<WorldChunk>& chunks)
+{
+  HSceneObject chunksSO = SceneObject::create(worldName + ".worldmesh");
+
+  for (const WorldChunk& chunk : chunks)
+  {
+    HSceneObject chunkSO = SceneObject::create(chunk.meshName);
+    chunkSO->setParent(chunksSO);
+    chunkSO->setActive(false);
+  }
+
+  return chunksSO;
+}
+
+void BsZenLib::UpdateWorldChunks(const HSceneObject& chunksSO, const Vector<WorldChunk>& chunks,
+                                 const Vector3& viewPosition, float loadDistance,
+                                 UINT32 maxLoadsPerUpdate)
+{
+  UnorderedMap<String, HSceneObject> chunkSOs;
+
+  for (UINT32 i = 0; i < chunksSO->getNumChildren(); i++)
+  {
+    HSceneObject child = chunksSO->getChild(i);
+    chunkSOs[child->getName()] = child;
+  }
+
+  // Distance and index of the chunks to load
+  Vector<std::pair<float, UINT32>> toLoad;
+
+  for (UINT32 i = 0; i < (UINT32)chunks.size(); i++)
+  {
+    auto it = chunkSOs.find(chunks[i].meshName);
+
+    if (it == chunkSOs.end()) continue;
+
+    float distance = distanceToBounds(chunks[i].bounds, viewPosition);
+
+    if (distance > loadDistance)
+    {
+      if (isChunkLoaded(it->second)) unloadChunk(it->second);
+    }
+    else if (!isChunkLoaded(it->second))
+    {
+      toLoad.emplace_back(distance, i);
+    }
+  }
+
+  std::sort(toLoad.begin(), toLoad.end());
+
+  for (size_t i = 0; i < toLoad.size() && i < maxLoadsPerUpdate; i++)
+  {
+    const WorldChunk& chunk = chunks[toLoad[i].second];
+
+    loadChunk(chunkSOs[chunk.meshName], chunk, toLoad[i].first);
+  }
+}
+
+static Map<ChunkCoord, Vector<ChunkTriangle>> assignTrianglesToChunks(
+    const ZenLoad::PackedMesh& worldMesh, float chunkSize)
+{
+  Map<ChunkCoord, Vector<ChunkTriangle>> cells;
+
+  const auto& vertices = worldMesh.vertices;
+
+  for (UINT32 submesh = 0; submesh < (UINT32)worldMesh.subMeshes.size(); submesh++)
+  {
+    const auto& indices = worldMesh.subMeshes[submesh].indices;
+
+    for (UINT32 i = 0; i + 2 < (UINT32)indices.size(); i += 3)
+    {
+      float centerX = 0.0f;
+      float centerZ = 0.0f;
+
+      for (UINT32 k = 0; k < 3; k++)
+      {
+        centerX += vertices[indices[i + k]].Position.x;
+        centerZ += vertices[indices[i + k]].Position.z;
+      }
+
+      ChunkCoord coord;
+      coord.x = (INT32)std::floor(centerX / 3.0f / chunkSize);
+      coord.z = (INT32)std::floor(centerZ / 3.0f / chunkSize);
+
+      cells[coord].push_back({submesh, i});
+    }
+  }
+
+  return cells;
+}
+
+/**
+ * Copies the given triangles of the world mesh into a mesh of their own, together with the
+ * vertices they use and the materials of the submeshes they are part of.
+ *
+ * @param triangles  Triangles of the chunk, sorted by submesh.
+ */
+static void buildChunk(const ZenLoad::PackedMesh& worldMesh, const Vector<HMaterial>& materials,
+                       const Vector<ChunkTriangle>& triangles, ZenLoad::PackedMesh& outMesh,
+                       Vector<HMaterial>& outMaterials, AABox& outBounds)
+{
+  Vector<UINT32> usedVertices;
+  usedVertices.reserve(triangles.size() * 3);
+
+  for (const ChunkTriangle& triangle : triangles)
+  {
+    const auto& indices = worldMesh.subMeshes[triangle.submesh].indices;
+
+    for (UINT32 k = 0; k < 3; k++)
+    {
+      usedVertices.push_back(indices[triangle.firstIndex + k]);
+    }
+  }
+
+  std::sort(usedVertices.begin(), usedVertices.end());
+  usedVertices.erase(std::unique(usedVertices.begin(), usedVertices.end()), usedVertices.end());
+
+  Vector3 boundsMin(Vector3::INF);
+  Vector3 boundsMax(-Vector3::INF);
+
+  for (UINT32 v : usedVertices)
+  {
+    const auto& vertex = worldMesh.vertices[v];
+    Vector3 position(vertex.Position.x, vertex.Position.y, vertex.Position.z);
+
+    boundsMin = Vector3::min(boundsMin, position);
+    boundsMax = Vector3::max(boundsMax, position);
+
+    outMesh.vertices.push_back(vertex);
+  }
+
+  outBounds = AABox(boundsMin, boundsMax);
+
+  UINT32 currentSubmesh = std::numeric_limits<UINT32>::max();
+
+  for (const ChunkTriangle& triangle : triangles)
+  {
+    if (triangle.submesh != currentSubmesh)
+    {
+      currentSubmesh = triangle.submesh;
+
+      outMesh.subMeshes.emplace_back();
+      outMesh.subMeshes.back().material = worldMesh.subMeshes[currentSubmesh].material;
+      outMaterials.push_back(currentSubmesh < materials.size() ? materials[currentSubmesh]
+                                                               : HMaterial());
+    }
+
+    const auto& indices = worldMesh.subMeshes[triangle.submesh].indices;
+    auto& chunkIndices = outMesh.subMeshes.back().indices;
+
+    for (UINT32 k = 0; k < 3; k++)
+    {
+      auto it = std::lower_bound(usedVertices.begin(), usedVertices.end(),
+                                 indices[triangle.firstIndex + k]);
+
+      chunkIndices.push_back((uint32_t)(it - usedVertices.begin()));
+    }
+  }
+}
+
+static String chunkMeshName(const String& worldName, const ChunkCoord& coord)
+{
+  return worldName + ".worldmesh.chunk" + toString(coord.x) + "_" + toString(coord.z);
+}
+
+static bool saveChunkIndex(const String& worldName, float chunkSize,
+                           const CacheSourceStamp& stamp, const Vector<WorldChunk>& chunks)
+{
+  LineRecordWriter records;
+
+  records.write(chunkSize);
+  records.write(stamp.sourceHash);
+  records.write(stamp.importerVersion);
+  records.endRecord();
+
+  for (const WorldChunk& chunk : chunks)
+  {
+    const Vector3& min = chunk.bounds.getMin();
+    const Vector3& max = chunk.bounds.getMax();
+
+    records.write(min.x);
+    records.write(min.y);
+    records.write(min.z);
+    records.write(max.x);
+    records.write(max.y);
+    records.write(max.z);
+    records.endRecord(chunk.meshName);
+  }
+
+  Path path = GothicPathToCachedWorldChunks(worldName);
+
+  if (!records.save(path))
+  {
+    BS_LOG(Error, Uncategorized, "Could not write chunk index to {0}", path);
+    return false;
+  }
+
+  return true;
+}
+
+static bool readChunkIndex(const String& worldName, float& outChunkSize,
+                           CacheSourceStamp& outStamp, Vector<WorldChunk>& outChunks)
+{
+  LineRecordReader records;
+
+  if (!records.open(GothicPathToCachedWorldChunks(worldName))) return false;
+  if (!records.nextRecord() || !records.read(outChunkSize)) return false;
+
+  // Indices written before they had a stamp keep stamp 0, which never matches
+  outStamp = CacheSourceStamp();
+  records.read(outStamp.sourceHash);
+  records.read(outStamp.importerVersion);
+
+  while (records.nextRecord())
+  {
+    float fields[6];
+    bool isValid = true;
+
+    for (float& field : fields)
+    {
+      isValid = isValid && records.read(field);
+    }
+
+    if (!isValid) continue;
+
+    WorldChunk chunk;
+    chunk.bounds = AABox(Vector3(fields[0], fields[1], fields[2]),
+                         Vector3(fields[3], fields[4], fields[5]));
+    chunk.meshName = records.readRest();
+
+    if (chunk.meshName.empty()) continue;
+
+    outChunks.push_back(chunk);
+  }
+
+  return true;
+}
+
+/**
+ * Loads the mesh of the chunk and sets up its renderable and collider. With texture streaming
+ * enabled, the full textures of its materials are requested as well, nearer chunks first.
+ *
+ * @param distance  Distance of the chunk to the viewer.
+ *
+ * @return False, if the mesh could not be loaded.
+ */
+static bool loadChunk(const HSceneObject& chunkSO, const WorldChunk& chunk, float distance)
+{
+  Res::HMeshWithMaterials mesh = LoadCachedStaticMesh(chunk.meshName);
+
+  if (!mesh || !mesh->getMesh())
+  {
+    BS_LOG(Warning, Uncategorized, "Load Failed (World Chunk): " + chunk.meshName);
+    return false;
+  }
+
+  HRenderable renderable = chunkSO->getComponent<CRenderable>();
+
+  if (!renderable)
+  {
+    renderable = chunkSO->addComponent<CRenderable>();
+  }
+
+  renderable->setMesh(mesh->getMesh());
+  renderable->setMaterials(mesh->getMaterials());
+
+  if (IsTextureStreamingEnabled())
+  {
+    for (const HMaterial& material : mesh->getMaterials())
+    {
+      RequestMaterialDetail(material, -distance);
+    }
+  }
+
+  if (mesh->getMesh()->getCachedData())
+  {
+    GameObjectHandle<CMeshCollider> collider = chunkSO->getComponent<CMeshCollider>();
+
+    if (!collider)
+    {
+      collider = chunkSO->addComponent<CMeshCollider>();
+    }
+
+    collider->setMesh(
+        PhysicsMesh::create(mesh->getMesh()->getCachedData(), PhysicsMeshType::Triangle));
+  }
+
+  chunkSO->setActive(true);
+
+  return true;
+}
+
+/**
+ * Drops the references of the chunk to its mesh, materials and physics mesh, releases the mesh
+ * loaded by loadChunk() and deactivates the chunk.
+ */
+static void unloadChunk(const HSceneObject& chunkSO)
+{
+  UUID uuid;
+
+  if (gResources().getUUIDFromFilePath(GothicPathToCachedStaticMesh(chunkSO->getName()), uuid))
+  {
+    HResource mesh = gResources()._getResourceHandle(uuid);
+
+    if (mesh.isLoaded(false)) gResources().release(mesh);
+  }
+
+  HRenderable renderable = chunkSO->getComponent<CRenderable>();
+
+  if (renderable)
+  {
+    renderable->setMesh(HMesh());
+    renderable->setMaterials({});
+  }
+
+  GameObjectHandle<CMeshCollider> collider = chunkSO->getComponent<CMeshCollider>();
+
+  if (collider)
+  {
+    collider->setMesh(HPhysicsMesh());
+  }
+
+  chunkSO->setActive(false);
+}
+
+static bool isChunkLoaded(const HSceneObject& chunkSO)
+{
+  HRenderable renderable = chunkSO->getComponent<CRenderable>();
+
+  return renderable && renderable->getMesh();
+}
+
+static float distanceToBounds(const AABox& bounds, const Vector3& position)
+{
+  const Vector3& min = bounds.getMin();
+  const Vector3& max = bounds.getMax();
+
+  Vector3 closest(Math::clamp(position.x, min.x, max.x), Math::clamp(position.y, min.y, max.y),
+                  Math::clamp(position.z, min.z, max.z));
+
+  return closest.distance(position);
+}
@@ -0,0 +1,381 @@
+/**
+ * bszen-cache
+ * ===========
+ *
+ * Builds the cache for the given .VDF-archives without opening a window, so it can run on
+ * headless machines. bs::f is started with its null render, audio and physics backends.
+ *
+ * Usage:
+ *
+ *     bszen-cache [--jobs=N] [--only=tex,mrm,mds,zen] [--dry-run] [--pack]
+ *                 [--metrics=FILE] [--trace=FILE] [--mip-filter=kaiser|box]
+ *                 [--compress=none|bc1bc3|bc7]
+ *                 [--compress-quality=fastest|normal|production|highest]
+ *                 [--vertex-format=full|compact] [--optimize-meshes]
+ *                 [--world-chunks=METERS] <archive.vdf>...
+ *
+ * The exit code is 0 if everything was cached, 1 if some files failed to import and -1 on
+ * invalid arguments.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "BsApplication.h"
+#include <BsZenLib/CacheUtility.hpp>
+#include <BsZenLib/ImportStaticMesh.hpp>
+#include <BsZenLib/ImportTexture.hpp>
+#include <BsZenLib/ResourceManifest.hpp>
+#include <BsZenLib/WorldChunks.hpp>
+#include <vdfs/fileIndex.h>
+
+using namespace bs;
+
+static void printUsage()
+{
+  std::cout << "Usage: bszen-cache [options] <archive.vdf>..." << std::endl
+            << std::endl
+            << "Options:" << std::endl
+            << "  --jobs=N         Run at most N imports at once (Default: one per core)"
+            << std::endl
+            << "  --only=KINDS     Only cache the given kinds of files, separated by comma."
+            << std::endl
+            << "                   Kinds are: tex, mrm, mds, zen (Default: all of them)"
+            << std::endl
+            << "  --dry-run        Only list the files which would be imported" << std::endl
+            << "  --pack           Pack the whole cache into a single file afterwards"
+            << std::endl
+            << "  --metrics=FILE   Write time and bytes spent per import stage as JSON"
+            << std::endl
+            << "  --trace=FILE     Write all import stages as Chrome trace (chrome://tracing)"
+            << std::endl
+            << "  --mip-filter=F   Filter for mip-maps of uncompressed textures: kaiser, box"
+            << std::endl
+            << "                   (Default: kaiser)" << std::endl
+            << "  --compress=C     Block compress uncompressed textures: none, bc1bc3, bc7"
+            << std::endl
+            << "                   (Default: none)" << std::endl
+            << "  --compress-quality=Q" << std::endl
+            << "                   Encoder quality: fastest, normal, production, highest"
+            << std::endl
+            << "                   (Default: normal)" << std::endl
+            << "  --vertex-format=F" << std::endl
+            << "                   Vertex layout of static meshes: full, compact" << std::endl
+            << "                   (Default: full)" << std::endl
+            << "  --optimize-meshes" << std::endl
+            << "                   Reorder static mesh triangles and vertices for the GPU"
+            << std::endl
+            << "  --world-chunks=METERS" << std::endl
+            << "                   Also split world meshes into chunks of this size" << std::endl
+            << "                   (Default: 0, not split)" << std::endl;
+}
+
+/**
+ * @return False, if the filter is unknown.
+ */
+static bool parseMipFilter(String filter, BsZenLib::TextureMipFilter& outFilter)
+{
+  StringUtil::toLowerCase(filter);
+
+  if (filter == "kaiser")
+  {
+    outFilter = BsZenLib::TextureMipFilter::Kaiser;
+  }
+  else if (filter == "box")
+  {
+    outFilter = BsZenLib::TextureMipFilter::Box;
+  }
+  else
+  {
+    std::cout << "Unknown mip-map filter: " << filter << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @return False, if the compression is unknown.
+ */
+static bool parseCompression(String compression, BsZenLib::TextureCompression& outCompression)
+{
+  StringUtil::toLowerCase(compression);
+
+  if (compression == "none")
+  {
+    outCompression = BsZenLib::TextureCompression::None;
+  }
+  else if (compression == "bc1bc3")
+  {
+    outCompression = BsZenLib::TextureCompression::BC1OrBC3;
+  }
+  else if (compression == "bc7")
+  {
+    outCompression = BsZenLib::TextureCompression::BC7;
+  }
+  else
+  {
+    std::cout << "Unknown texture compression: " << compression << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @return False, if the quality is unknown.
+ */
+static bool parseCompressionQuality(String quality, CompressionQuality& outQuality)
+{
+  StringUtil::toLowerCase(quality);
+
+  if (quality == "fastest")
+  {
+    outQuality = CompressionQuality::Fastest;
+  }
+  else if (quality == "normal")
+  {
+    outQuality = CompressionQuality::Normal;
+  }
+  else if (quality == "production")
+  {
+    outQuality = CompressionQuality::Production;
+  }
+  else if (quality == "highest")
+  {
+    outQuality = CompressionQuality::Highest;
+  }
+  else
+  {
+    std::cout << "Unknown compression quality: " << quality << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @return False, if the format is unknown.
+ */
+static bool parseVertexFormat(String format, BsZenLib::StaticMeshVertexFormat& outFormat)
+{
+  StringUtil::toLowerCase(format);
+
+  if (format == "full")
+  {
+    outFormat = BsZenLib::StaticMeshVertexFormat::Full;
+  }
+  else if (format == "compact")
+  {
+    outFormat = BsZenLib::StaticMeshVertexFormat::Compact;
+  }
+  else
+  {
+    std::cout << "Unknown vertex format: " << format << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @return False, if one of the given kinds is unknown.
+ */
+static bool parseOnly(const String& kinds, BsZenLib::CacheOptions& options)
+{
+  options.textures = false;
+  options.staticMeshes = false;
+  options.modelScripts = false;
+  options.worlds = false;
+
+  for (String kind : StringUtil::split(kinds, ","))
+  {
+    StringUtil::trim(kind);
+    StringUtil::toLowerCase(kind);
+
+    if (kind == "tex")
+    {
+      options.textures = true;
+    }
+    else if (kind == "mrm")
+    {
+      options.staticMeshes = true;
+    }
+    else if (kind == "mds")
+    {
+      options.modelScripts = true;
+    }
+    else if (kind == "zen")
+    {
+      options.worlds = true;
+    }
+    else
+    {
+      std::cout << "Unknown kind of file: " << kind << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  VDFS::FileIndex::initVDFS(argv[0]);
+
+  BsZenLib::CacheOptions options;
+  BsZenLib::TextureMipFilter mipFilter = BsZenLib::TextureMipFilter::Kaiser;
+  BsZenLib::TextureCompressionOptions compression;
+  BsZenLib::StaticMeshVertexFormat vertexFormat = BsZenLib::StaticMeshVertexFormat::Full;
+  bool optimizeMeshes = false;
+  float worldChunkSize = 0.0f;
+  Vector<String> archives;
+
+  for (int i = 1; i < argc; i++)
+  {
+    String arg = argv[i];
+
+    if (arg == "--help" || arg == "-h")
+    {
+      printUsage();
+      return 0;
+    }
+    else if (StringUtil::startsWith(arg, "--jobs=", false))
+    {
+      int jobs = atoi(arg.substr(7).c_str());
+
+      if (jobs <= 0)
+      {
+        std::cout << "Invalid number of jobs: " << arg << std::endl;
+        return -1;
+      }
+
+      options.maxJobs = (UINT32)jobs;
+    }
+    else if (StringUtil::startsWith(arg, "--only=", false))
+    {
+      if (!parseOnly(arg.substr(7), options)) return -1;
+    }
+    else if (arg == "--dry-run")
+    {
+      options.dryRun = true;
+    }
+    else if (arg == "--pack")
+    {
+      options.buildPack = true;
+    }
+    else if (StringUtil::startsWith(arg, "--metrics=", false))
+    {
+      options.metricsFile = arg.substr(10);
+    }
+    else if (StringUtil::startsWith(arg, "--trace=", false))
+    {
+      options.traceFile = arg.substr(8);
+    }
+    else if (StringUtil::startsWith(arg, "--mip-filter=", false))
+    {
+      if (!parseMipFilter(arg.substr(13), mipFilter)) return -1;
+    }
+    else if (StringUtil::startsWith(arg, "--compress=", false))
+    {
+      if (!parseCompression(arg.substr(11), compression.compression)) return -1;
+    }
+    else if (StringUtil::startsWith(arg, "--compress-quality=", false))
+    {
+      if (!parseCompressionQuality(arg.substr(19), compression.quality)) return -1;
+    }
+    else if (StringUtil::startsWith(arg, "--vertex-format=", false))
+    {
+      if (!parseVertexFormat(arg.substr(16), vertexFormat)) return -1;
+    }
+    else if (arg == "--optimize-meshes")
+    {
+      optimizeMeshes = true;
+    }
+    else if (StringUtil::startsWith(arg, "--world-chunks=", false))
+    {
+      worldChunkSize = (float)atof(arg.substr(15).c_str());
+
+      if (worldChunkSize < 0.0f)
+      {
+        std::cout << "Invalid chunk size: " << arg << std::endl;
+        return -1;
+      }
+    }
+    else if (StringUtil::startsWith(arg, "--", false))
+    {
+      std::cout << "Unknown option: " << arg << std::endl;
+      printUsage();
+      return -1;
+    }
+    else
+    {
+      archives.push_back(arg);
+    }
+  }
+
+  if (archives.empty())
+  {
+    printUsage();
+    return -1;
+  }
+
+  VDFS::FileIndex vdfs;
+
+  for (const String& archive : archives)
+  {
+    vdfs.loadVDF(archive.c_str());
+  }
+
+  vdfs.finalizeLoad();
+
+  if (vdfs.getKnownFiles().empty())
+  {
+    std::cout << "No files loaded into the VDFS - are the paths correct?" << std::endl;
+    return -1;
+  }
+
+  START_UP_DESC desc = Application::buildStartUpDesc(VideoMode(64, 64), "bszen-cache", false);
+  desc.renderAPI = "bsfNullRenderAPI";
+  desc.renderer = "bsfNullRenderer";
+  desc.audio = "bsfNullAudio";
+  desc.physics = "bsfNullPhysics";
+
+  Application::startUp(desc);
+
+  BsZenLib::SetTextureMipFilter(mipFilter);
+  BsZenLib::SetTextureCompression(compression);
+  BsZenLib::SetStaticMeshVertexFormat(vertexFormat);
+  BsZenLib::SetStaticMeshOptimization(optimizeMeshes);
+  BsZenLib::SetWorldChunkSize(worldChunkSize);
+  BsZenLib::LoadResourceManifest();
+  BsZenLib::CacheWholeVDFS(vdfs, options);
+
+  Vector<String> outdated = BsZenLib::GetOutdatedCacheFiles();
+  Vector<BsZenLib::CacheFailure> failures = BsZenLib::GetCacheFailures();
+
+  if (options.dryRun)
+  {
+    for (const String& file : outdated)
+    {
+      std::cout << file << std::endl;
+    }
+
+    std::cout << outdated.size() << " file(s) would be cached" << std::endl;
+  }
+  else
+  {
+    for (const BsZenLib::CacheFailure& failure : failures)
+    {
+      std::cout << "FAILED: " << failure.file << ": " << failure.reason << std::endl;
+    }
+
+    std::cout << "Imported " << outdated.size() << " file(s), " << failures.size() << " failed"
+              << std::endl;
+  }
+
+  BsZenLib::FlushResourceManifestJournal();
+  Application::shutDown();
+
+  return failures.empty() ? 0 : 1;
+}